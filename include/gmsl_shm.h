@@ -0,0 +1,137 @@
+/**
+ * @file   gmsl_shm.h
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  Shared-memory stats export (--shm), layout for readers.
+ *
+ * The monitor publishes the stats of each chain into a POSIX shared-memory
+ * segment which any number of readers can map read-only:
+ *
+ *   fd = shm_open("/gmsl_stats", O_RDONLY, 0);
+ *   pshm = mmap(NULL, sizeof(gmsl_shm), PROT_READ, MAP_SHARED, fd, 0);
+ *
+ * Each chain has its own sequence counter, odd while the monitor is
+ * writing it. A reader takes the counter, reads what it needs in place
+ * and retries if the counter moved. A monitor killed in the middle of a
+ * write leaves the counter odd, so the wait for it is bounded:
+ *
+ *   do {
+ *       if (gmsl_shm_read_begin(&pshm->chains[0], &seq) < 0)
+ *           break;
+ *       locked = pshm->chains[0].des.ports[0].flags & GMSL_SHM_DES_LOCKED;
+ *   } while (gmsl_shm_read_retry(&pshm->chains[0], seq));
+ *
+ * Layout rules: fixed-width fields in host byte order, naturally aligned,
+ * no pointers. Fields are only ever added at the end of a struct with the
+ * struct sizes in the header telling readers where the arrays are; a
+ * change to existing fields bumps GMSL_SHM_VERSION.
+ */
+
+#ifndef __GMSL_SHM__H__
+#define __GMSL_SHM__H__
+
+#include <stdint.h>
+
+#define GMSL_SHM_MAGIC          (0x4C534D47U)   /* "GMSL" */
+#define GMSL_SHM_VERSION        (1)
+
+#define GMSL_SHM_MAX_CHAINS     (8)
+#define GMSL_SHM_MAX_LINKS      (4)
+#define GMSL_SHM_MAX_PORTS      (4)
+#define GMSL_SHM_MAX_COUNTERS   (8)
+#define GMSL_SHM_NAME_LEN       (16)
+#define GMSL_SHM_READ_SPINS     (1000000)   /* Polls of a write in progress, a write takes microseconds */
+
+/* Deserializer port flags */
+#define GMSL_SHM_DES_ERROR          (1U << 0)
+#define GMSL_SHM_DES_REMOTE_ERR     (1U << 1)
+#define GMSL_SHM_DES_LOCKED         (1U << 2)   /* Video pipeline */
+#define GMSL_SHM_DES_THR_OK         (1U << 3)
+#define GMSL_SHM_DES_BLK_LEN_ERR    (1U << 4)
+#define GMSL_SHM_DES_SEQ_ERR        (1U << 5)
+#define GMSL_SHM_DES_OVERFLOW       (1U << 6)
+#define GMSL_SHM_DES_TUN_OVERFLOW   (1U << 7)
+#define GMSL_SHM_DES_LCRC_ERR       (1U << 8)
+#define GMSL_SHM_DES_TUNNEL         (1U << 9)
+
+/* Serializer port flags */
+#define GMSL_SHM_SER_ERROR          (1U << 0)
+#define GMSL_SHM_SER_PCLK_DET       (1U << 1)
+#define GMSL_SHM_SER_PCLK_DRIFT     (1U << 2)
+#define GMSL_SHM_SER_FIFO_WARN      (1U << 3)
+#define GMSL_SHM_SER_FIFO_OVERFLOW  (1U << 4)
+#define GMSL_SHM_SER_TUN_OVERFLOW   (1U << 5)
+#define GMSL_SHM_SER_TUNNEL         (1U << 6)
+
+/* MIPI port of a chip */
+typedef struct gmsl_shm_port_ {
+    uint32_t    flags;                              /* GMSL_SHM_DES_* or GMSL_SHM_SER_* */
+    uint32_t    reserved;
+    uint64_t    counters[GMSL_SHM_MAX_COUNTERS];    /* Totals since the monitor started */
+    uint32_t    deltas[GMSL_SHM_MAX_COUNTERS];      /* Over the last counters period */
+} gmsl_shm_port;
+
+/* Deserializer, or the serializer of a link */
+typedef struct gmsl_shm_chip_ {
+    char        name[GMSL_SHM_NAME_LEN];    /* "MAX96724", empty - not found */
+    uint32_t    num_ports;
+    uint32_t    num_counters;
+    uint64_t    flags_ns;                   /* Monitor clock of the last flags sample */
+    uint64_t    counters_ns;                /* And of the last counters sample */
+    uint64_t    period_ns;                  /* Between the last two counters samples */
+    char        counter_names[GMSL_SHM_MAX_COUNTERS][GMSL_SHM_NAME_LEN];
+    gmsl_shm_port ports[GMSL_SHM_MAX_PORTS];
+} gmsl_shm_chip;
+
+typedef struct gmsl_shm_chain_ {
+    uint32_t    seq;                        /* Odd while being written */
+    int32_t     bus;                        /* i2c-N, -1 - slot not in use */
+    uint32_t    num_links;
+    uint32_t    link_speed[GMSL_SHM_MAX_LINKS];    /* Gbps, 0 - down */
+    uint32_t    reserved;
+    uint64_t    updates;                    /* Completed writes */
+    gmsl_shm_chip des;
+    gmsl_shm_chip ser[GMSL_SHM_MAX_LINKS];
+} gmsl_shm_chain;
+
+typedef struct gmsl_shm_ {
+    uint32_t    magic;                      /* GMSL_SHM_MAGIC once set up */
+    uint32_t    version;                    /* GMSL_SHM_VERSION */
+    uint32_t    header_size;                /* Offset of chains[] */
+    uint32_t    chain_size;                 /* sizeof(gmsl_shm_chain) */
+    uint32_t    chip_size;                  /* sizeof(gmsl_shm_chip) */
+    uint32_t    port_size;                  /* sizeof(gmsl_shm_port) */
+    uint32_t    num_chains;
+    int32_t     writer_pid;                 /* 0 - the monitor has stopped */
+    gmsl_shm_chain chains[GMSL_SHM_MAX_CHAINS];
+} gmsl_shm;
+
+/**
+ * Start of a read of a chain: waits out a write in progress. Returns -1
+ * if the write does not end, the writer is gone (see writer_pid).
+ * */
+static inline int gmsl_shm_read_begin(const gmsl_shm_chain *pchain, uint32_t *pseq)
+{
+    uint32_t spins;
+
+    for (spins = 0; spins < GMSL_SHM_READ_SPINS; spins++)
+    {
+        *pseq = __atomic_load_n(&pchain->seq, __ATOMIC_ACQUIRE);
+        if ((*pseq & 1) == 0)
+            return 0;
+    }
+
+    return -1;
+}
+
+/**
+ * Non-zero if the chain was written during the read, which must be redone
+ * */
+static inline int gmsl_shm_read_retry(const gmsl_shm_chain *pchain, uint32_t seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return __atomic_load_n(&pchain->seq, __ATOMIC_RELAXED) != seq;
+}
+
+#endif
@@ -11,33 +11,162 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
 
 #define SERIALIZER_MAX_PORTS      (4)
 #define DESERIALIZER_MAX_PORTS    (4)
+#define DESERIALIZER_MAX_LINKS    (4)
 
 #define FEATURE_DES_3GBPS         (1 << 0)
 #define FEATURE_DES_6GBPS         (1 << 1)
 #define FEATURE_DES_12GBPS        (1 << 2)
+#define LINK_NEG_MAX_RATES        (3)
 
 #define ARRAY_SIZE(x)       (sizeof(x)/sizeof(x[0]))
 
+#define PROFILE_TEXT        (1)
+#define PROFILE_JSON        (2)
+#define PROFILE_MAX_PHASES  (16)
+
+/* Transaction queue: up to I2C_RDWR_IOCTL_MAX_MSGS messages per ioctl */
+#define I2C_BATCH_MAX_MSGS  I2C_RDWR_IOCTL_MAX_MSGS
+#define I2C_BATCH_POOL_SIZE (I2C_BATCH_MAX_MSGS * 4)
+
+#define SERDES_MAX_CHAINS   (8)
+
+/* Multi-link chains: serializer and translated sensor address of link n */
+#define SERIALIZER_LINK_I2C_SA  (0x44)
+#define SENSOR_LINK_I2C_SA      (0x30)
+
+/* MAX96712/MAX96724 2x4 mode: port n is PHY 2n and 2n + 1 on MIPI TX controller n + 1 */
+#define MAX9672X_MIPI_TX_BASE(port)     (0x0940 + 0x40 * (port))
+#define MAX9672X_PHY_RATE_REG(port)     (0x0415 + 6 * (port))   /* BACKTOP22, BACKTOP28; +3 - BACKTOP25, BACKTOP31 */
+
+#define REGCACHE_SIZE       (0x10000)
+#define REGCACHE_VOLATILE   (0xFF)
+
+/* Bus of a chain with its addresses, 0 - --dsa/--ssa or autoscan */
+typedef struct serdes_chain_cfg_ {
+    int             i2c_port;
+    int             deser_i2c_sa;
+    int             ser_i2c_sa;
+} serdes_chain_cfg;
+
 typedef struct st_app_params_ {
     int             i2c_port;
-    int             mipi_rx_lanes;
-    uint16_t        mipi_rx_map;
-    uint16_t        mipi_rx_pol;
+    int             mipi_rx_ports;  /* Serializer MIPI RX ports to set up */
+    int             mipi_rx_lanes[SERIALIZER_MAX_PORTS];
+    uint16_t        mipi_rx_map[SERIALIZER_MAX_PORTS];
+    uint16_t        mipi_rx_pol[SERIALIZER_MAX_PORTS];
     int             mipi_rx_skew_en;
-    int             mipi_tx_lanes;
-    uint16_t        mipi_tx_map;
-    uint16_t        mipi_tx_pol;
+    int             mipi_tx_lanes[DESERIALIZER_MAX_PORTS];
+    uint16_t        mipi_tx_map[DESERIALIZER_MAX_PORTS];
+    uint16_t        mipi_tx_pol[DESERIALIZER_MAX_PORTS];
     int             mipi_tx_deskew_en;
-    int             mipi_tx_out_freq;
+    int             mipi_tx_out_freq[DESERIALIZER_MAX_PORTS];
     int             stats_flags;
+    unsigned int    monitor_ms;         /* Counters sampling period, 0 - one snapshot */
+    unsigned int    monitor_samples;    /* 0 - until interrupted */
+    unsigned int    monitor_flags_ms;   /* Lock and error flags sampling period */
+    const char      *shm_name;          /* Monitor stats export, see gmsl_shm.h */
+    const char      *metrics_spec;      /* OpenMetrics TCP port or Unix socket path */
     int             ser_i2c_sa;
     int             deser_i2c_sa;
+    int             sensor_i2c_sa;
     int             no_init;
+    int             reg_cache;
+    int             delta_mode;
+    const char      *state_file;
+    int             profile;
+    int             trace;
+    const char      *sim_spec;
+    const char      *record_file;
+    const char      *replay_file;
+    const char      *topology_file;
+    int             num_chains;
+    serdes_chain_cfg chains[SERDES_MAX_CHAINS];
 } st_app_params, *pst_app_params;
 
+struct i2c_bus_;
+struct gmsl_shm_chain_;
+
+/* Bus access backend, transfer() takes I2C_RDWR messages and returns < 0 with errno set */
+typedef struct i2c_transport_ {
+    const char  *name;
+    int         (*open)(struct i2c_bus_ *pbus);
+    int         (*close)(struct i2c_bus_ *pbus);
+    int         (*transfer)(struct i2c_bus_ *pbus, struct i2c_msg *msgs, int nmsgs);
+    uint64_t    (*now_ns)(struct i2c_bus_ *pbus);                           /* NULL - CLOCK_MONOTONIC */
+    void        (*sleep_until_ns)(struct i2c_bus_ *pbus, uint64_t wake_ns); /* NULL - clock_nanosleep() */
+    void        *priv;
+} i2c_transport;
+
+typedef struct profile_phase_ {
+    const char      *name;
+    uint64_t        time_us;
+    uint64_t        sleep_us;
+    unsigned int    xfers;      /* I2C_RDWR ioctls */
+    unsigned int    reads;
+    unsigned int    writes;
+    unsigned int    bytes;
+} profile_phase_t;
+
+typedef struct profile_ctx_ {
+    profile_phase_t phases[PROFILE_MAX_PHASES];
+    int             num_phases;
+    int             current;    /* -1 - not counting */
+    uint64_t        mark_us;
+} profile_ctx;
+
+/* One I2C adapter: transport, transaction queue and bring-up profile */
+typedef struct i2c_bus_ {
+    int                 bus_num;
+    int                 fd;         /* i2c-dev */
+    const i2c_transport *tp;
+    void                *tp_priv;   /* Transport state of this bus */
+    struct i2c_msg      batch_msgs[I2C_BATCH_MAX_MSGS];
+    unsigned char       batch_pool[I2C_BATCH_POOL_SIZE];
+    int                 batch_nmsgs;
+    int                 batch_pool_used;
+    int                 batch_depth;
+    int                 batch_error;
+    profile_ctx         profile;
+} i2c_bus, *pi2c_bus;
+
+typedef struct regcache_range_ {
+    uint16_t    first;
+    uint16_t    last;
+    uint8_t     sc_mask;    /* Bits changed by hardware, REGCACHE_VOLATILE - whole register */
+    uint8_t     reset_mask; /* Reset bits, setting one drops the whole cache */
+} regcache_range;
+
+typedef struct regcache_ {
+    uint8_t                 value[REGCACHE_SIZE];
+    uint8_t                 valid[REGCACHE_SIZE / 8];
+    const regcache_range    *ranges;
+    int                     num_ranges;
+    int                     delta;      /* Skip writes of values already in place */
+    unsigned int            hits;
+    unsigned int            misses;
+    unsigned int            writes;
+    unsigned int            elided;
+    unsigned int            settle_mark;
+} regcache, *pregcache;
+
+typedef struct reg_seq_entry_ {
+    uint16_t    addr;
+    uint8_t     value;
+    uint8_t     mask;       /* 0xFF - write, other - update masked bits, 0 - delay only */
+    uint32_t    delay_us;   /* Delay after the entry, timeout of a poll */
+    uint8_t     poll;       /* Wait for (reg & mask) == value instead of writing */
+} reg_seq_entry;
+
+#define SEQ_WRITE(a, v)             { (a), (v), 0xFF, 0, 0 }
+#define SEQ_UPDATE(a, v, m)         { (a), (v), (m), 0, 0 }
+#define SEQ_DELAY(d)                { 0, 0, 0, (d), 0 }
+#define SEQ_POLL(a, v, m, t)        { (a), (v), (m), (t), 1 }
+
 typedef struct serializer_stats_ {
     int global_status;
     int global_pkt_count;
@@ -75,14 +204,71 @@ typedef struct deserializer_stats_ {
     int lcrc_error_flag;
 } deserializer_stats, *pdeserializer_stats;
 
+/* Register groups of get_stats(), sampled at their own rate by --monitor */
+#define STATS_GROUP_FLAGS       (1 << 0)    /* Lock and error flags */
+#define STATS_GROUP_COUNTERS    (1 << 1)    /* Packet and PHY error counters */
+#define STATS_GROUP_DUMP        (1 << 2)    /* Raw register dump, snapshot only */
+#define STATS_GROUP_ALL         (STATS_GROUP_FLAGS | STATS_GROUP_COUNTERS | STATS_GROUP_DUMP)
+
+/* OpenMetrics families the monitor renders per chain */
+#define METRICS_LINK_SPEED  (0)
+#define METRICS_FLAG        (1)
+#define METRICS_COUNTER     (2)
+#define METRICS_RATE        (3)
+#define METRICS_FAMILIES    (4)
+
+#define COUNTER_CLEARED     (1 << 0)    /* Cleared after each read instead of wrapping */
+
+/* Packets per second the counters are expected to count at most */
+#define COUNTER_MAX_RATE    (1000)
+/* Longest sampling period that can not miss a wrap of a counter */
+#define COUNTER_MAX_PERIOD_MS(bits) ((((1U << (bits)) - 1) * 1000) / COUNTER_MAX_RATE)
+
+/* Stats field in a register: (reg >> shift) & mask, read in one of the groups */
+typedef struct reg_stats_entry_ {
+    uint16_t    addr;
+    uint8_t     mask;
+    uint8_t     shift;
+    uint8_t     port;       /* Stats of the port the field is in */
+    uint8_t     group;      /* STATS_GROUP_* */
+    uint8_t     flags;      /* STATS_REG_* */
+    uint16_t    offset;     /* Of the int in serializer_stats/deserializer_stats */
+} reg_stats_entry;
+
+#define STATS_REG_ERROR     (1 << 0)    /* Non-zero is stored as -1 */
+#define STATS_REG_INVERT    (1 << 1)    /* Zero is a set field (LOCKED as an error) */
+#define STATS_REG_OR        (1 << 2)    /* ORed into the field of the entries before */
+
+/* Hardware counter in the stats of a chip port, for --monitor */
+typedef struct stats_counter_desc_ {
+    const char  *name;
+    uint16_t    offset;     /* Of the int in serializer_stats/deserializer_stats */
+    uint8_t     bits;       /* Counter width */
+    uint8_t     flags;
+    uint32_t    max_period_ms;  /* Sampling period limit, 0 - none */
+} stats_counter_desc;
+
 typedef struct serializer_ctx_ {
+    pi2c_bus            bus;
     uint8_t             i2c_slave_address;
+    pregcache           regcache;
+    unsigned int        link_lock_ms;   /* Time the last wait_for_link took */
+    uint8_t             rx_port_mask;   /* MIPI RX ports set up */
+    const reg_stats_entry *stats;
+    int                 num_stats;
     serializer_stats    ser_stats[SERIALIZER_MAX_PORTS];
 } serializer_ctx, *pserializer_ctx;
 
 typedef struct deserializer_ctx_ {
+    pi2c_bus            bus;
     uint8_t             i2c_slave_address;
+    pregcache           regcache;
     uint32_t            features;
+    int                 link_speed;     /* Negotiated rate, Gbps */
+    unsigned int        link_lock_ms;   /* Time the last wait_for_link took */
+    uint8_t             link_mask;      /* Links the link functions act on, 0 - all */
+    const reg_stats_entry *stats;
+    int                 num_stats;
     deserializer_stats  deser_stats[DESERIALIZER_MAX_PORTS];
 } deserializer_ctx, *pdeserializer_ctx;
 
@@ -90,6 +276,12 @@ typedef struct serializer_entry_ {
     uint8_t ser_devid;
     char    ser_name[32];
     int     rx_ports;
+    const regcache_range *volatile_regs;
+    int     num_volatile_regs;
+    const reg_stats_entry *stats;
+    int     num_stats;
+    const stats_counter_desc *counters;     /* Per port */
+    int     num_counters;
     /* Functions */
     int (*init)(pserializer_ctx pctx);
     int (*start)(pserializer_ctx pctx);
@@ -98,13 +290,22 @@ typedef struct serializer_entry_ {
     int (*reset_link)(pserializer_ctx pctx);
     int (*wait_for_link)(pserializer_ctx pctx);
     int (*set_link_speed_gbps)(pserializer_ctx pctx, int speed);
-    int (*get_stats)(pserializer_ctx pctx);
+    int (*get_stats)(pserializer_ctx pctx, uint32_t groups);    /* NULL - stats table only */
 } serializer_entry;
 
 typedef struct deserializer_entry_ {
     uint8_t deser_devid;
     char    deser_name[32];
     int     tx_ports;
+    int     csi_ports;      /* MIPI CSI-2 outputs set up, one controller each */
+    int     links;          /* GMSL links, 0 - one */
+    uint16_t lock_reg;      /* CTRL3 with LOCKED at bit 3 */
+    const regcache_range *volatile_regs;
+    int     num_volatile_regs;
+    const reg_stats_entry *stats;
+    int     num_stats;
+    const stats_counter_desc *counters;     /* Per TX port */
+    int     num_counters;
     /* Functions */
     int (*init)(pdeserializer_ctx pctx);
     int (*start)(pdeserializer_ctx pctx);
@@ -114,16 +315,80 @@ typedef struct deserializer_entry_ {
     int (*reset_link)(pdeserializer_ctx pctx);
     int (*wait_for_link)(pdeserializer_ctx pctx);
     int (*set_link_speed_gbps)(pdeserializer_ctx pctx, int speed);
-    int (*get_stats)(pdeserializer_ctx pctx);
+    int (*get_stats)(pdeserializer_ctx pctx, uint32_t groups);  /* NULL - stats table only */
+    /* Multi-link chips */
+    int (*get_link_status)(pdeserializer_ctx pctx, uint8_t *locked_mask);
+    int (*select_link)(pdeserializer_ctx pctx, int link);
 } deserializer_entry;
 
-int  i2c_init(int i2c_bus_num);
-int  i2c_exit(void);
-int  i2c_read_reg8a8(unsigned char dev_addr,unsigned char reg_addr,unsigned char *buf);
-int  i2c_read_reg8a16(unsigned char dev_addr,unsigned short reg_addr,unsigned char *buf);
-int  i2c_write_reg8a16(unsigned char dev_addr,unsigned short reg_addr,unsigned char value_byte);
-int  i2c_write_reg8a8(unsigned char dev_addr,unsigned char reg_addr,unsigned char value_byte);
-int  i2c_write_buffer(unsigned char dev_addr,unsigned char *pbuf,size_t length);
+/* GMSL link of the deserializer and the serializer behind it */
+typedef struct serdes_link_ {
+    serializer_ctx      ser_content;
+    int                 found_inx_ser;
+    int                 locked;
+    int                 speed;          /* Rate the link locked at, Gbps, 0 - unknown */
+    unsigned int        lock_ms;        /* From the start of the bring-up */
+    unsigned int        up_ms;          /* Serializer configured */
+} serdes_link, *pserdes_link;
+
+/* Deserializer and serializers behind it, sharing one bus */
+typedef struct serdes_chain_ {
+    i2c_bus             bus;
+    deserializer_ctx    deser_content;
+    serdes_link         links[DESERIALIZER_MAX_LINKS];
+    int                 num_links;
+    int                 num_links_up;
+    int                 found_inx_deser;
+    int                 deser_i2c_sa;   /* 0 - autoscan */
+    int                 ser_i2c_sa;
+    int                 status;         /* EXIT_SUCCESS, EXIT_FAILURE */
+    const char          *error;
+    int                 index;          /* In app_params.chains */
+    uint64_t            start_us;
+    unsigned int        bringup_ms;
+} serdes_chain, *pserdes_chain;
+
+void i2c_set_transport(const i2c_transport *ptp);
+const i2c_transport *i2c_get_transport(void);
+int  i2c_init(pi2c_bus pbus, int i2c_bus_num);
+int  i2c_exit(pi2c_bus pbus);
+int  i2c_read_reg8a8(pi2c_bus pbus,unsigned char dev_addr,unsigned char reg_addr,unsigned char *buf);
+int  i2c_read_reg8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,unsigned char *buf);
+int  i2c_read_burst8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,unsigned char *buf,size_t length);
+int  i2c_write_reg8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,unsigned char value_byte);
+int  i2c_write_reg8a8(pi2c_bus pbus,unsigned char dev_addr,unsigned char reg_addr,unsigned char value_byte);
+int  i2c_write_buffer(pi2c_bus pbus,unsigned char dev_addr,unsigned char *pbuf,size_t length);
+int  i2c_write_burst8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,const unsigned char *buf,size_t length);
+int  i2c_batch_begin(pi2c_bus pbus);
+int  i2c_batch_read_reg8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,unsigned char *buf);
+int  i2c_batch_read_burst8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,unsigned char *buf,size_t length);
+int  i2c_batch_flush(pi2c_bus pbus);
+int  i2c_batch_end(pi2c_bus pbus);
+int  i2c_sim_setup(const char *spec);
+int  i2c_record_start(const char *path);
+int  i2c_replay_setup(const char *path);
+
+uint64_t time_monotonic_ns(pi2c_bus pbus);
+uint64_t time_monotonic_us(pi2c_bus pbus);
+void time_sleep_us(pi2c_bus pbus, unsigned int delay_us);
+void time_sleep_until_us(pi2c_bus pbus, uint64_t wake_us);
+int  poll_until(pi2c_bus pbus, int (*cond)(void *arg), void *arg, unsigned int timeout_ms,
+        unsigned int *elapsed_ms);
+int  poll_reg8a16(pi2c_bus pbus, unsigned char dev_addr, unsigned short reg_addr, unsigned char mask,
+        unsigned char value, unsigned int timeout_ms, unsigned int *elapsed_ms);
+
+pregcache regcache_create(const regcache_range *ranges, int num_ranges);
+void regcache_destroy(pregcache pcache);
+void regcache_invalidate(pregcache pcache);
+int  regcache_read_reg8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, unsigned short reg_addr, unsigned char *buf);
+int  regcache_read_burst8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, unsigned short reg_addr, unsigned char *buf, size_t length);
+int  regcache_read_regs8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, const unsigned short *reg_addr, unsigned char *buf, int count);
+int  regcache_read_bursts8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, const unsigned short *reg_addr, const unsigned char *length, unsigned char *buf, int count);
+int  regcache_prefetch8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, const unsigned short *reg_addr, int count);
+int  regcache_write_needed(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, unsigned short reg_addr, unsigned char value_byte);
+int  regcache_write_reg8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, unsigned short reg_addr, unsigned char value_byte);
+int  regcache_write_burst8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, unsigned short reg_addr, const unsigned char *buf, size_t length);
+int  regcache_settle_needed(pregcache pcache);
 
 int  max96717_init(pserializer_ctx pctx);
 int  max96717_start(pserializer_ctx pctx);
@@ -132,7 +397,7 @@ int  max96717_set_mipi_rx_params(pserializer_ctx pctx,
 int  max96717_reset_link(pserializer_ctx pctx);
 int  max96717_wait_for_link(pserializer_ctx pctx);
 int  max96717_set_link_speed_gbps(pserializer_ctx pctx, int speed);
-int  max96717_get_stats(pserializer_ctx pctx);
+int  max96717_get_stats(pserializer_ctx pctx, uint32_t groups);
 
 int  max96793_init(pserializer_ctx pctx);
 int  max96793_start(pserializer_ctx pctx);
@@ -141,7 +406,7 @@ int  max96793_set_mipi_rx_params(pserializer_ctx pctx,
 int  max96793_reset_link(pserializer_ctx pctx);
 int  max96793_wait_for_link(pserializer_ctx pctx);
 int  max96793_set_link_speed_gbps(pserializer_ctx pctx, int speed);
-int  max96793_get_stats(pserializer_ctx pctx);
+int  max96793_get_stats(pserializer_ctx pctx, uint32_t groups);
 
 int  max9295d_init(pserializer_ctx pctx);
 int  max9295d_start(pserializer_ctx pctx);
@@ -150,7 +415,7 @@ int  max9295d_set_mipi_rx_params(pserializer_ctx pctx,
 int  max9295d_reset_link(pserializer_ctx pctx);
 int  max9295d_wait_for_link(pserializer_ctx pctx);
 int  max9295d_set_link_speed_gbps(pserializer_ctx pctx, int speed);
-int  max9295d_get_stats(pserializer_ctx pctx);
+int  max9295d_get_stats(pserializer_ctx pctx, uint32_t groups);
 
 int  max96714_init(pdeserializer_ctx pctx);
 int  max96714_start(pdeserializer_ctx pctx);
@@ -159,7 +424,7 @@ int  max96714_set_mipi_tx_params(pdeserializer_ctx pctx,
 int  max96714_reset_link(pdeserializer_ctx pctx);
 int  max96714_wait_for_link(pdeserializer_ctx pctx);
 int  max96714_set_link_speed_gbps(pdeserializer_ctx pctx, int speed);
-int  max96714_get_stats(pdeserializer_ctx pctx);
+int  max96714_get_stats(pdeserializer_ctx pctx, uint32_t groups);
 
 int  max96792_init(pdeserializer_ctx pctx);
 int  max96792_start(pdeserializer_ctx pctx);
@@ -168,7 +433,7 @@ int  max96792_set_mipi_tx_params(pdeserializer_ctx pctx,
 int  max96792_reset_link(pdeserializer_ctx pctx);
 int  max96792_wait_for_link(pdeserializer_ctx pctx);
 int  max96792_set_link_speed_gbps(pdeserializer_ctx pctx, int speed);
-int  max96792_get_stats(pdeserializer_ctx pctx);
+int  max96792_get_stats(pdeserializer_ctx pctx, uint32_t groups);
 
 int  max96712_init(pdeserializer_ctx pctx);
 int  max96712_start(pdeserializer_ctx pctx);
@@ -177,7 +442,8 @@ int  max96712_set_mipi_tx_params(pdeserializer_ctx pctx,
 int  max96712_reset_link(pdeserializer_ctx pctx);
 int  max96712_wait_for_link(pdeserializer_ctx pctx);
 int  max96712_set_link_speed_gbps(pdeserializer_ctx pctx, int speed);
-int  max96712_get_stats(pdeserializer_ctx pctx);
+int  max96712_get_link_status(pdeserializer_ctx pctx, uint8_t *locked_mask);
+int  max96712_select_link(pdeserializer_ctx pctx, int link);
 
 int  max96724_init(pdeserializer_ctx pctx);
 int  max96724_start(pdeserializer_ctx pctx);
@@ -186,19 +452,91 @@ int  max96724_set_mipi_tx_params(pdeserializer_ctx pctx,
 int  max96724_reset_link(pdeserializer_ctx pctx);
 int  max96724_wait_for_link(pdeserializer_ctx pctx);
 int  max96724_set_link_speed_gbps(pdeserializer_ctx pctx, int speed);
-int  max96724_get_stats(pdeserializer_ctx pctx);
+int  max96724_get_link_status(pdeserializer_ctx pctx, uint8_t *locked_mask);
+int  max96724_select_link(pdeserializer_ctx pctx, int link);
 
 int  application_opt_parsing(int argc, char *argv[]);
 
-int  serializer_search_chip(void);
-int  serializer_init(uint32_t features);
-int  serializer_get_stat(void);
-int  deserializer_init(void);
-int  deserializer_search_for_serializer(void);
-uint32_t deserializer_get_features(void);
-int  deserializer_set_link_speed(int speed);
-int  deserializer_start(void);
-int  deserializer_get_stat(void);
+int  serdes_chain_load_topology(const char *path);
+int  serdes_chains_run(void);
+
+const char *profile_phase(pi2c_bus pbus, const char *name);
+void profile_count_i2c(pi2c_bus pbus, unsigned int reads, unsigned int writes, unsigned int bytes);
+void profile_count_sleep(pi2c_bus pbus, unsigned int delay_us);
+void profile_report(pi2c_bus pbus);
+
+void trace_init(void);
+void trace_transfer(pi2c_bus pbus, const struct i2c_msg *msgs, int nmsgs, uint64_t start_ns,
+        uint64_t dur_ns, int result, int err);
+void trace_dump(void);
+
+int  link_neg_order(uint32_t features, const int *preferred, int num_preferred, int *speeds);
+int  link_neg_run(uint32_t features, const int *preferred, int num_preferred,
+        int (*try_speed)(void *arg, int speed), void *arg);
+int  link_state_load(int bus, uint8_t deser_addr, uint8_t ser_devid);
+int  link_state_save(int bus, uint8_t deser_addr, uint8_t ser_devid, int speed);
+
+int  reg_seq_run(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, const reg_seq_entry *seq, int count);
+int  reg_stats_read(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, const reg_stats_entry *table, int count,
+        uint32_t groups, void *stats, size_t stride);
+
+int  serializer_read_reg(pserializer_ctx pctx, uint16_t reg_addr, uint8_t *buf);
+int  serializer_read_burst(pserializer_ctx pctx, uint16_t reg_addr, uint8_t *buf, size_t length);
+int  serializer_write_reg(pserializer_ctx pctx, uint16_t reg_addr, uint8_t value);
+void serializer_settle(pserializer_ctx pctx, unsigned int delay_us);
+void serializer_settle_ready(pserializer_ctx pctx, uint16_t reg_addr, uint8_t mask, uint8_t value,
+        unsigned int delay_us);
+int  serializer_poll_reg(pserializer_ctx pctx, uint16_t reg_addr, uint8_t mask, uint8_t value,
+        unsigned int timeout_ms, unsigned int *elapsed_ms);
+int  serializer_run_seq(pserializer_ctx pctx, const reg_seq_entry *seq, int count);
+int  serializer_read_stats(pserializer_ctx pctx, uint32_t groups);
+int  serializer_search_chip(pserdes_chain pchain, int link);
+int  serializer_init(pserdes_chain pchain, int link, uint32_t features);
+int  serializer_get_stat(pserdes_chain pchain, int link);
+uint8_t serializer_get_devid(pserdes_chain pchain, int link);
+const stats_counter_desc *serializer_sample_stats(pserdes_chain pchain, int link, uint32_t groups,
+        int *num_counters, int *num_ports);
+const char *serializer_get_name(pserdes_chain pchain, int link);
+void serializer_exit(pserdes_chain pchain);
+int  deserializer_read_reg(pdeserializer_ctx pctx, uint16_t reg_addr, uint8_t *buf);
+int  deserializer_read_burst(pdeserializer_ctx pctx, uint16_t reg_addr, uint8_t *buf, size_t length);
+int  deserializer_read_regs(pdeserializer_ctx pctx, const uint16_t *reg_addr, uint8_t *buf, int count);
+int  deserializer_write_reg(pdeserializer_ctx pctx, uint16_t reg_addr, uint8_t value);
+void deserializer_settle(pdeserializer_ctx pctx, unsigned int delay_us);
+void deserializer_settle_ready(pdeserializer_ctx pctx, uint16_t reg_addr, uint8_t mask, uint8_t value,
+        unsigned int delay_us);
+int  deserializer_poll_reg(pdeserializer_ctx pctx, uint16_t reg_addr, uint8_t mask, uint8_t value,
+        unsigned int timeout_ms, unsigned int *elapsed_ms);
+int  deserializer_run_seq(pdeserializer_ctx pctx, const reg_seq_entry *seq, int count);
+int  deserializer_read_stats(pdeserializer_ctx pctx, uint32_t groups);
+int  deserializer_link_locked(pserdes_chain pchain);
+int  deserializer_search_chip(pserdes_chain pchain);
+int  deserializer_init(pserdes_chain pchain);
+int  deserializer_search_for_serializer(pserdes_chain pchain);
+int  deserializer_search_for_serializers(pserdes_chain pchain,
+        void (*link_up)(pserdes_chain pchain, int link));
+int  deserializer_select_link(pserdes_chain pchain, int link);
+int  deserializer_negotiate_link(pserdes_chain pchain, int link, int preferred);
+uint8_t deserializer_get_i2c_address(pserdes_chain pchain);
+uint32_t deserializer_get_features(pserdes_chain pchain);
+const char *deserializer_get_name(pserdes_chain pchain);
+int  deserializer_set_link_speed(pserdes_chain pchain, int speed);
+int  deserializer_start(pserdes_chain pchain);
+int  deserializer_get_stat(pserdes_chain pchain);
+const stats_counter_desc *deserializer_sample_stats(pserdes_chain pchain, uint32_t groups,
+        int *num_counters, int *num_ports);
+void deserializer_exit(pserdes_chain pchain);
+
+int  monitor_run(pserdes_chain pchain);
+
+int  shm_export_open(const char *name, int num_chains);
+void shm_export_close(void);
+struct gmsl_shm_chain_ *shm_export_write_begin(int chain);
+void shm_export_write_end(struct gmsl_shm_chain_ *pchain);
+
+int  metrics_open(const char *spec);
+void metrics_close(void);
+void metrics_update(int chain, int family, char *text, size_t len);
 
 extern st_app_params app_params;
 
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <unistd.h>
 #include <getopt.h>
 #include "serdes_head.h"
@@ -18,27 +19,113 @@ st_app_params app_params;
 void display_usage(const char *prog_name) {
     printf("Usage: %s [options]\n", prog_name);
     printf("Options:\n");
-    printf("  -i, --i2c <busnumber>   Specify the i2c bus number [default 4]\n");
-    printf("  -m, --maprx <hex>       Specify MIPI RX pins mapping for serializer\n");
-    printf("  -p, --polarityrx <hex>  Specify MIPI RX pins polarity for serializer\n");
-    printf("  -l, --lanesrx <val>     Specify MIPI RX lanes for serializer [default 4]\n");
-    printf("  -k, --maptx <hex>       Specify MIPI TX pins mapping for deserializer\n");
-    printf("  -o, --polaritytx <hex>  Specify MIPI TX pins polarity for deserializer\n");
-    printf("  -r, --lanestx <val>     Specify MIPI TX lanes for serializer [default 4]\n");
-    printf("  -t, --ratetx <val>      Specify MIPI TX transfer rate\n");
+    printf("  -i, --i2c <busnumber>   Specify the i2c bus number [default 4], a list (2,4,6,8) brings up chains in parallel\n");
+    printf("  -g, --topology <file>   Chains to bring up in parallel, one \"<bus> [<dsa> [<ssa>]]\" per line\n");
+    printf("  -m, --maprx <hex>       Specify MIPI RX pins mapping for serializer, per port: <port 0>,<port 1>\n");
+    printf("  -p, --polarityrx <hex>  Specify MIPI RX pins polarity for serializer, per port\n");
+    printf("  -l, --lanesrx <val>     Specify MIPI RX lanes for serializer, per port [default 4]\n");
+    printf("  -k, --maptx <hex>       Specify MIPI TX pins mapping for deserializer, per port: <port 0>,<port 1>\n");
+    printf("  -o, --polaritytx <hex>  Specify MIPI TX pins polarity for deserializer, per port\n");
+    printf("  -r, --lanestx <val>     Specify MIPI TX lanes for deserializer, per port [default 4]\n");
+    printf("  -t, --ratetx <val>      Specify MIPI TX transfer rate, per port\n");
+    printf("  -q, --config <file>     MIPI TX ports, one \"<port> <lanes> [<map> [<polarity> [<rate>]]]\" per line\n");
     printf("  -s, --stats             Statistics only\n");
+    printf("  -z, --monitor[=ms[,n[,flags ms]]]  Statistics only, sample counters every ms [default 1000], n times\n"
+           "                          [default - until Ctrl+C], lock and error flags every flags ms [default 50];\n"
+           "                          ms is cut to the wrap time of the counters at 1000 packets/s (15 ms for 4 bits)\n");
+    printf("  -S, --shm <name>        With --monitor, publish the stats to POSIX shared memory, e.g. /gmsl_stats\n");
+    printf("  -P, --metrics <port|path>  With --monitor, serve OpenMetrics on 127.0.0.1:port or a Unix socket\n");
     printf("  -n, --noinit            Without init\n");
+    printf("  -c, --cache             Enable shadow register cache\n");
+    printf("  -d, --delta             Write only registers which differ (re-apply config)\n");
+    printf("  -e, --state <file>      Last good link rate file [default /var/tmp/gmsl_tool.state, \"\" - off]\n");
+    printf("  -f, --profile[=json]    Print time and I2C traffic of each bring-up phase\n");
+    printf("  -x, --trace             Trace I2C transfers, dump on exit or SIGUSR1\n");
+    printf("  -u, --sim <des:ser>     Run against simulated chips, e.g. max96724:max96717[:lock ms[:xfer us[:remote us]]]\n");
+    printf("  -w, --record <file>     Record all I2C transfers to a binary log\n");
+    printf("  -y, --replay <file>     Serve I2C reads from a recorded log instead of the bus\n");
+    printf("  -j, --sensor <address>  Sensor I2C address, translated per link on multi-link deserializers\n");
     printf("  -a, --ssa <address>     Specify serializer I2C slave address [default - autoscan]\n");
     printf("  -b, --dsa <address>     Specify deserializer I2C slave address [default - autoscan]\n");
     printf("  -h, --help              Show this help message and exit\n");
 }
 
+/**
+ * Per-port option value "<port 0>[,<port 1>...]", the last value given
+ * is used for the ports after it. Returns the number of values given.
+ * */
+static int args_parse_ports(char *arg, int base, long *vals, int max_ports)
+{
+    char *pval;
+    int num = 0, i;
+
+    for (pval = strtok(arg, ","); (pval != NULL) && (num < max_ports); pval = strtok(NULL, ","))
+        vals[num++] = strtol(pval, NULL, base);
+
+    for (i = num; (num > 0) && (i < max_ports); i++)
+        vals[i] = vals[num - 1];
+
+    return num;
+}
+
+/**
+ * Read deserializer MIPI TX port settings from a file, map and polarity
+ * in hex, '#' starts a comment. Ports not listed keep their settings.
+ * */
+static int args_load_tx_config(const char *path)
+{
+    FILE *fp;
+    char line[128], *pcomment;
+    unsigned int map, pol;
+    int port, lanes, rate, n;
+
+    fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        printf("Error: can't open %s: %s\r\n", path, strerror(errno));
+        return -errno;
+    }
+
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        pcomment = strchr(line, '#');
+        if (pcomment != NULL)
+            *pcomment = '\0';
+
+        n = sscanf(line, "%d %d %x %x %d", &port, &lanes, &map, &pol, &rate);
+        if (n < 2)
+            continue;
+
+        if ((port < 0) || (port >= DESERIALIZER_MAX_PORTS))
+        {
+            printf("Error: no MIPI TX port %d, %s\r\n", port, path);
+            fclose(fp);
+            return -EINVAL;
+        }
+
+        app_params.mipi_tx_lanes[port] = lanes;
+        if (n > 2)
+            app_params.mipi_tx_map[port] = map;
+        if (n > 3)
+            app_params.mipi_tx_pol[port] = pol;
+        if (n > 4)
+            app_params.mipi_tx_out_freq[port] = rate;
+    }
+
+    fclose(fp);
+
+    return 0;
+}
+
 int application_opt_parsing(int argc, char *argv[]) {
-    int opt;
+    int opt, i, num;
+    char *pbus;
+    long vals[SERIALIZER_MAX_PORTS], tx_vals[DESERIALIZER_MAX_PORTS];
 
     // Define long options
     static struct option long_options[] = {
         {"i2c",         required_argument,  0, 'i'},
+        {"topology",    required_argument,  0, 'g'},
         {"maprx",       required_argument,  0, 'm'},
         {"polarityrx",  required_argument,  0, 'p'},
         {"lanesrx",     required_argument,  0, 'l'},
@@ -46,8 +133,21 @@ int application_opt_parsing(int argc, char *argv[]) {
         {"polaritytx",  required_argument,  0, 'o'},
         {"lanestx",     required_argument,  0, 'r'},
         {"ratetx",      required_argument,  0, 't'},
+        {"config",      required_argument,  0, 'q'},
         {"stats",       no_argument,        0, 's'},
+        {"monitor",     optional_argument,  0, 'z'},
+        {"shm",         required_argument,  0, 'S'},
+        {"metrics",     required_argument,  0, 'P'},
         {"noinit",      no_argument,        0, 'n'},
+        {"cache",       no_argument,        0, 'c'},
+        {"delta",       no_argument,        0, 'd'},
+        {"state",       required_argument,  0, 'e'},
+        {"profile",     optional_argument,  0, 'f'},
+        {"trace",       no_argument,        0, 'x'},
+        {"sim",         required_argument,  0, 'u'},
+        {"record",      required_argument,  0, 'w'},
+        {"replay",      required_argument,  0, 'y'},
+        {"sensor",      required_argument,  0, 'j'},
         {"ssa",         required_argument,  0, 'a'},
         {"dsa",         required_argument,  0, 'b'},
         {"help",        no_argument,        0, 'h'},
@@ -56,47 +156,137 @@ int application_opt_parsing(int argc, char *argv[]) {
 
     memset(&app_params, 0, sizeof(app_params));
     app_params.i2c_port          = 4;
-    app_params.mipi_rx_lanes     = 4;
-    app_params.mipi_rx_map       = 0x400E;
-    app_params.mipi_rx_pol       = 0x3402;
-    app_params.mipi_tx_lanes     = 4;
-    app_params.mipi_tx_map       = 0xE4;
-    app_params.mipi_tx_pol       = 0x00;
-    app_params.mipi_tx_out_freq  = 1500;
-
-    while ((opt = getopt_long(argc, argv, "a:b:i:m:p:l:k:o:r:t:hsn", long_options, NULL)) != -1) {
+    app_params.mipi_rx_ports     = 1;
+    for (i = 0; i < SERIALIZER_MAX_PORTS; i++)
+    {
+        app_params.mipi_rx_lanes[i] = 4;
+        app_params.mipi_rx_map[i]   = 0x400E;
+        app_params.mipi_rx_pol[i]   = 0x3402;
+    }
+    for (i = 0; i < DESERIALIZER_MAX_PORTS; i++)
+    {
+        app_params.mipi_tx_lanes[i]    = 4;
+        app_params.mipi_tx_map[i]      = 0xE4;
+        app_params.mipi_tx_pol[i]      = 0x00;
+        app_params.mipi_tx_out_freq[i] = 1500;
+    }
+    app_params.state_file        = "/var/tmp/gmsl_tool.state";
+
+    while ((opt = getopt_long(argc, argv, "a:b:g:i:j:m:p:l:k:o:r:t:q:e:f::u:w:y:z::S:P:hsncdx", long_options, NULL)) != -1) {
         // String in optarg
         switch (opt) {
             case 'i':
-                app_params.i2c_port = atol(optarg);
+                app_params.num_chains = 0;
+                for (pbus = strtok(optarg, ","); (pbus != NULL) &&
+                     (app_params.num_chains < SERDES_MAX_CHAINS); pbus = strtok(NULL, ","))
+                {
+                    app_params.chains[app_params.num_chains++].i2c_port = atol(pbus);
+                }
+                if (app_params.num_chains > 0)
+                    app_params.i2c_port = app_params.chains[0].i2c_port;
+                break;
+            case 'g':
+                app_params.topology_file = optarg;
                 break;
             case 'm':
-                app_params.mipi_rx_map = strtoul(optarg, NULL, 16);
+                num = args_parse_ports(optarg, 16, vals, SERIALIZER_MAX_PORTS);
+                for (i = 0; (num > 0) && (i < SERIALIZER_MAX_PORTS); i++)
+                    app_params.mipi_rx_map[i] = vals[i];
+                if (num > app_params.mipi_rx_ports)
+                    app_params.mipi_rx_ports = num;
                 break;
             case 'p':
-                app_params.mipi_rx_pol = strtoul(optarg, NULL, 16);
+                num = args_parse_ports(optarg, 16, vals, SERIALIZER_MAX_PORTS);
+                for (i = 0; (num > 0) && (i < SERIALIZER_MAX_PORTS); i++)
+                    app_params.mipi_rx_pol[i] = vals[i];
+                if (num > app_params.mipi_rx_ports)
+                    app_params.mipi_rx_ports = num;
                 break;
             case 'l':
-                app_params.mipi_rx_lanes = strtoul(optarg, NULL, 16);
+                num = args_parse_ports(optarg, 16, vals, SERIALIZER_MAX_PORTS);
+                for (i = 0; (num > 0) && (i < SERIALIZER_MAX_PORTS); i++)
+                    app_params.mipi_rx_lanes[i] = vals[i];
+                if (num > app_params.mipi_rx_ports)
+                    app_params.mipi_rx_ports = num;
                 break;
             case 'k':
-                app_params.mipi_tx_map = strtoul(optarg, NULL, 16);
+                num = args_parse_ports(optarg, 16, tx_vals, DESERIALIZER_MAX_PORTS);
+                for (i = 0; (num > 0) && (i < DESERIALIZER_MAX_PORTS); i++)
+                    app_params.mipi_tx_map[i] = tx_vals[i];
                 break;
             case 'o':
-                app_params.mipi_tx_pol = strtoul(optarg, NULL, 16);
+                num = args_parse_ports(optarg, 16, tx_vals, DESERIALIZER_MAX_PORTS);
+                for (i = 0; (num > 0) && (i < DESERIALIZER_MAX_PORTS); i++)
+                    app_params.mipi_tx_pol[i] = tx_vals[i];
                 break;
             case 'r':
-                app_params.mipi_tx_lanes = atol(optarg);
+                num = args_parse_ports(optarg, 10, tx_vals, DESERIALIZER_MAX_PORTS);
+                for (i = 0; (num > 0) && (i < DESERIALIZER_MAX_PORTS); i++)
+                    app_params.mipi_tx_lanes[i] = tx_vals[i];
                 break;
             case 't':
-                app_params.mipi_tx_out_freq = atol(optarg);
+                num = args_parse_ports(optarg, 10, tx_vals, DESERIALIZER_MAX_PORTS);
+                for (i = 0; (num > 0) && (i < DESERIALIZER_MAX_PORTS); i++)
+                    app_params.mipi_tx_out_freq[i] = tx_vals[i];
+                break;
+            case 'q':
+                if (args_load_tx_config(optarg) < 0)
+                    return 1;
                 break;
             case 's':
                 app_params.stats_flags = 1;
                 break;
+            case 'z':
+                app_params.stats_flags = 1;
+                app_params.monitor_ms = 1000;
+                app_params.monitor_samples = 0;
+                app_params.monitor_flags_ms = 50;
+                if (optarg != NULL)
+                    sscanf(optarg, "%u,%u,%u", &app_params.monitor_ms, &app_params.monitor_samples,
+                            &app_params.monitor_flags_ms);
+                if (app_params.monitor_ms == 0)
+                    app_params.monitor_ms = 1000;
+                if (app_params.monitor_flags_ms == 0)
+                    app_params.monitor_flags_ms = 50;
+                break;
+            case 'S':
+                app_params.shm_name = optarg;
+                break;
+            case 'P':
+                app_params.metrics_spec = optarg;
+                break;
             case 'n':
                 app_params.no_init = 1;
                 break;
+            case 'c':
+                app_params.reg_cache = 1;
+                break;
+            case 'd':
+                app_params.delta_mode = 1;
+                break;
+            case 'e':
+                app_params.state_file = optarg;
+                break;
+            case 'f':
+                app_params.profile = PROFILE_TEXT;
+                if ((optarg != NULL) && (strcmp(optarg, "json") == 0))
+                    app_params.profile = PROFILE_JSON;
+                break;
+            case 'x':
+                app_params.trace = 1;
+                break;
+            case 'u':
+                app_params.sim_spec = optarg;
+                break;
+            case 'w':
+                app_params.record_file = optarg;
+                break;
+            case 'y':
+                app_params.replay_file = optarg;
+                break;
+            case 'j':
+                app_params.sensor_i2c_sa = strtoul(optarg, NULL, 16);
+                break;
             case 'a':
                 app_params.ser_i2c_sa = strtoul(optarg, NULL, 16);
                 break;
@@ -112,10 +302,34 @@ int application_opt_parsing(int argc, char *argv[]) {
         }
     }
 
+    if (app_params.num_chains == 0)
+    {
+        app_params.chains[0].i2c_port = app_params.i2c_port;
+        app_params.num_chains = 1;
+    }
+
+    if ((app_params.shm_name != NULL) && (app_params.monitor_ms == 0))
+    {
+        printf("Error: --shm needs --monitor\r\n");
+        return 1;
+    }
+
+    if ((app_params.metrics_spec != NULL) && (app_params.monitor_ms == 0))
+    {
+        printf("Error: --metrics needs --monitor\r\n");
+        return 1;
+    }
+
     // Display the parsed options
-    printf("I2C bus: %d\n", app_params.i2c_port);
+    printf("I2C bus: %d", app_params.chains[0].i2c_port);
+    for (i = 1; i < app_params.num_chains; i++)
+        printf(",%d", app_params.chains[i].i2c_port);
+    printf("\n");
 
-    printf("Serializer MIPI lanes: %d\r\n", app_params.mipi_rx_lanes);
+    printf("Serializer MIPI lanes: %d", app_params.mipi_rx_lanes[0]);
+    for (i = 1; i < app_params.mipi_rx_ports; i++)
+        printf(",%d", app_params.mipi_rx_lanes[i]);
+    printf("\r\n");
 
     // Handle remaining arguments (non-option arguments)
     if (optind < argc) {
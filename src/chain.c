@@ -0,0 +1,380 @@
+/**
+ * @file   chain.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  Chain bring-up, one worker thread per bus.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "serdes_head.h"
+
+/**
+ * Read chains from a file: "<bus> [<dsa> [<ssa>]]" per line, addresses
+ * in hex, '#' starts a comment
+ * */
+int serdes_chain_load_topology(const char *path)
+{
+    FILE *fp;
+    char line[128], *pcomment;
+    unsigned int deser_sa, ser_sa;
+    int bus, n;
+
+    fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        printf("Error: can't open %s: %s\r\n", path, strerror(errno));
+        return -errno;
+    }
+
+    app_params.num_chains = 0;
+
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        pcomment = strchr(line, '#');
+        if (pcomment != NULL)
+            *pcomment = '\0';
+
+        deser_sa = 0;
+        ser_sa = 0;
+        n = sscanf(line, "%d %x %x", &bus, &deser_sa, &ser_sa);
+        if (n < 1)
+            continue;
+
+        if (app_params.num_chains == SERDES_MAX_CHAINS)
+        {
+            printf("Error: more than %d chains in %s\r\n", SERDES_MAX_CHAINS, path);
+            fclose(fp);
+            return -EINVAL;
+        }
+
+        app_params.chains[app_params.num_chains].i2c_port = bus;
+        app_params.chains[app_params.num_chains].deser_i2c_sa = deser_sa;
+        app_params.chains[app_params.num_chains].ser_i2c_sa = ser_sa;
+        app_params.num_chains++;
+    }
+
+    fclose(fp);
+
+    if (app_params.num_chains == 0)
+    {
+        printf("Error: no chains in %s\r\n", path);
+        return -EINVAL;
+    }
+
+    app_params.i2c_port = app_params.chains[0].i2c_port;
+
+    return 0;
+}
+
+/**
+ * Open the bus of a chain, nothing found on it yet
+ * */
+static int serdes_chain_open(pserdes_chain pchain, const serdes_chain_cfg *pcfg)
+{
+    int i;
+
+    memset(pchain, 0, sizeof(serdes_chain));
+    pchain->found_inx_deser = -1;
+    pchain->deser_content.bus = &pchain->bus;
+    pchain->num_links = 1;
+    for (i = 0; i < DESERIALIZER_MAX_LINKS; i++)
+    {
+        pchain->links[i].found_inx_ser = -1;
+        pchain->links[i].ser_content.bus = &pchain->bus;
+    }
+    pchain->deser_i2c_sa = (pcfg->deser_i2c_sa != 0) ? pcfg->deser_i2c_sa : app_params.deser_i2c_sa;
+    pchain->ser_i2c_sa = (pcfg->ser_i2c_sa != 0) ? pcfg->ser_i2c_sa : app_params.ser_i2c_sa;
+    pchain->index = pcfg - app_params.chains;
+
+    return i2c_init(&pchain->bus, pcfg->i2c_port);
+}
+
+static void serdes_chain_close(pserdes_chain pchain)
+{
+    serializer_exit(pchain);
+    deserializer_exit(pchain);
+    i2c_exit(&pchain->bus);
+}
+
+/**
+ * Link of a multi-link chain locked: set up its serializer right away,
+ * the first one also starts the deserializer output
+ * */
+static void serdes_chain_link_up(pserdes_chain pchain, int link)
+{
+    pi2c_bus pbus = &pchain->bus;
+    const char *prev_phase;
+
+    prev_phase = profile_phase(pbus, "discovery");
+
+    if (serializer_search_chip(pchain, link) < 0)
+    {
+        printf("Link %c: serializer not found\r\n", 'A' + link);
+        goto serdes_chain_link_up_end;
+    }
+
+    if (app_params.stats_flags != 0)
+        goto serdes_chain_link_up_end;
+
+    profile_phase(pbus, "serializer_init");
+    if (serializer_init(pchain, link, deserializer_get_features(pchain)) < 0)
+        goto serdes_chain_link_up_end;
+
+    if (pchain->num_links_up++ == 0)
+        deserializer_start(pchain);
+
+    pchain->links[link].up_ms = (unsigned int)((time_monotonic_us(pbus) - pchain->start_us) / 1000);
+
+serdes_chain_link_up_end:
+    profile_phase(pbus, prev_phase);
+}
+
+/**
+ * Stats only: one snapshot, or --monitor sampling until stopped
+ * */
+static void serdes_chain_stats(pserdes_chain pchain)
+{
+    int link;
+
+    profile_phase(&pchain->bus, "stats");
+
+    if (app_params.monitor_ms != 0)
+    {
+        monitor_run(pchain);
+    } else {
+        for (link = 0; link < pchain->num_links; link++)
+            serializer_get_stat(pchain, link);
+        deserializer_get_stat(pchain);
+    }
+
+    pchain->status = EXIT_SUCCESS;
+}
+
+/**
+ * Multi-link deserializer: links come up independently, the chain is up
+ * when at least one of them is
+ * */
+static void serdes_chain_bringup_links(pserdes_chain pchain)
+{
+    pi2c_bus pbus = &pchain->bus;
+
+    /* With --noinit the links keep their rate, only the ones locked are set up */
+    profile_phase(pbus, "link_negotiation");
+    if (deserializer_search_for_serializers(pchain, serdes_chain_link_up) <= 0)
+    {
+        pchain->error = "Serializer not found";
+        return;
+    }
+
+    if (app_params.stats_flags != 0)
+    {
+        serdes_chain_stats(pchain);
+        return;
+    }
+
+    if (pchain->num_links_up == 0)
+    {
+        pchain->error = "Serializer not found";
+        return;
+    }
+
+    pchain->status = EXIT_SUCCESS;
+}
+
+static void serdes_chain_bringup(pserdes_chain pchain)
+{
+    pi2c_bus pbus = &pchain->bus;
+
+    pchain->status = EXIT_FAILURE;
+
+    pchain->start_us = time_monotonic_us(pbus);
+
+    profile_phase(pbus, "discovery");
+    deserializer_search_chip(pchain);
+
+    profile_phase(pbus, "deserializer_init");
+    if (deserializer_init(pchain) < 0)
+    {
+        pchain->error = "Deserializer not found";
+        goto serdes_chain_bringup_end;
+    }
+
+    if (pchain->num_links > 1)
+    {
+        serdes_chain_bringup_links(pchain);
+        goto serdes_chain_bringup_end;
+    }
+
+    if (app_params.no_init == 0)
+    {
+        profile_phase(pbus, "link_negotiation");
+        if (deserializer_search_for_serializer(pchain) < 0)
+        {
+            pchain->error = "Serializer not found";
+            goto serdes_chain_bringup_end;
+        }
+    }
+
+    profile_phase(pbus, "discovery");
+    serializer_search_chip(pchain, 0);
+
+    if (app_params.stats_flags != 0)
+    {
+        serdes_chain_stats(pchain);
+        goto serdes_chain_bringup_end;
+    }
+
+    profile_phase(pbus, "serializer_init");
+    serializer_init(pchain, 0, deserializer_get_features(pchain));
+
+    deserializer_start(pchain);
+
+    pchain->status = EXIT_SUCCESS;
+
+serdes_chain_bringup_end:
+    profile_phase(pbus, NULL);
+    pchain->bringup_ms = (unsigned int)((time_monotonic_us(pbus) - pchain->start_us) / 1000);
+}
+
+static void serdes_chain_report_links(pserdes_chain pchain)
+{
+    pserdes_link plink;
+    int link;
+
+    for (link = 0; link < pchain->num_links; link++)
+    {
+        plink = &pchain->links[link];
+
+        if (plink->locked == 0)
+        {
+            printf("Link %c: down\r\n", 'A' + link);
+            continue;
+        }
+
+        printf("Link %c: ", 'A' + link);
+        if (plink->speed != 0)
+            printf("%dG, ", plink->speed);
+
+        if (plink->up_ms != 0)
+            printf("locked at %u ms, up at %u ms\r\n", plink->lock_ms, plink->up_ms);
+        else
+            printf("locked at %u ms, serializer not set up\r\n", plink->lock_ms);
+    }
+}
+
+static void *serdes_chain_worker(void *arg)
+{
+    serdes_chain_bringup((pserdes_chain)arg);
+    return NULL;
+}
+
+/**
+ * Bring up every configured chain, each on its own thread when there
+ * are several. Returns EXIT_FAILURE if any of them failed.
+ * */
+int serdes_chains_run(void)
+{
+    pserdes_chain chains;
+    pthread_t threads[SERDES_MAX_CHAINS];
+    int started[SERDES_MAX_CHAINS];
+    unsigned int slowest_ms = 0, num_ok = 0;
+    uint64_t start_us;
+    int ret = EXIT_SUCCESS, i;
+
+    chains = calloc(app_params.num_chains, sizeof(serdes_chain));
+    if (chains == NULL)
+        return EXIT_FAILURE;
+
+    if ((app_params.shm_name != NULL) &&
+        (shm_export_open(app_params.shm_name, app_params.num_chains) < 0))
+    {
+        free(chains);
+        return EXIT_FAILURE;
+    }
+
+    if ((app_params.metrics_spec != NULL) && (metrics_open(app_params.metrics_spec) < 0))
+    {
+        shm_export_close();
+        free(chains);
+        return EXIT_FAILURE;
+    }
+
+    start_us = time_monotonic_us(NULL);
+
+    for (i = 0; i < app_params.num_chains; i++)
+    {
+        started[i] = 0;
+
+        if (serdes_chain_open(&chains[i], &app_params.chains[i]) < 0)
+        {
+            chains[i].status = EXIT_FAILURE;
+            chains[i].error = "Bus open failed";
+            continue;
+        }
+
+        if (app_params.num_chains == 1)
+        {
+            serdes_chain_bringup(&chains[i]);
+            continue;
+        }
+
+        if (pthread_create(&threads[i], NULL, serdes_chain_worker, &chains[i]) != 0)
+        {
+            /* Out of threads, do it here */
+            serdes_chain_bringup(&chains[i]);
+            continue;
+        }
+
+        started[i] = 1;
+    }
+
+    for (i = 0; i < app_params.num_chains; i++)
+    {
+        if (started[i] != 0)
+            pthread_join(threads[i], NULL);
+    }
+
+    for (i = 0; i < app_params.num_chains; i++)
+    {
+        if (app_params.num_chains > 1)
+            printf("======== Chain i2c-%d =====================\r\n", app_params.chains[i].i2c_port);
+
+        if ((chains[i].num_links > 1) && (app_params.stats_flags == 0))
+            serdes_chain_report_links(&chains[i]);
+
+        if (chains[i].status == EXIT_SUCCESS)
+        {
+            if (app_params.stats_flags == 0)
+                printf("Bring-up time: %u ms\r\n", chains[i].bringup_ms);
+            num_ok++;
+            if (chains[i].bringup_ms > slowest_ms)
+                slowest_ms = chains[i].bringup_ms;
+        } else {
+            printf("Error: %s!\r\n", (chains[i].error != NULL) ? chains[i].error : "Bring-up failed");
+            ret = EXIT_FAILURE;
+        }
+
+        profile_report(&chains[i].bus);
+        serdes_chain_close(&chains[i]);
+    }
+
+    if (app_params.num_chains > 1)
+    {
+        printf("======== Chains ==========================\r\n");
+        printf("%u of %d chains up, slowest %u ms, wall clock %u ms\r\n",
+                num_ok, app_params.num_chains, slowest_ms,
+                (unsigned int)((time_monotonic_us(NULL) - start_us) / 1000));
+    }
+
+    metrics_close();
+    shm_export_close();
+
+    free(chains);
+
+    return ret;
+}
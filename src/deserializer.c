@@ -17,14 +17,170 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
 #include "serdes_head.h"
 
+#define LINK_WAIT_TIME_MS (2000)
+#define LINK_LOCK_WINDOW_MS (250)     /* Links already powered keep locking this long after the first one */
+
+#define DES_COUNTER(name, field, bits, flags) \
+    { (name), offsetof(deserializer_stats, field), (bits), (flags), COUNTER_MAX_PERIOD_MS(bits) }
+
+#define DES_STAT(addr, mask, shift, port, group, field, flags) \
+    { (addr), (mask), (shift), (port), (group), (flags), offsetof(deserializer_stats, field) }
+#define DES_STAT_BIT(addr, bit, port, field) \
+    DES_STAT((addr), 0x01, (bit), (port), STATS_GROUP_FLAGS, field, 0)
+#define DES_STAT_CNT(addr, mask, shift, port, field) \
+    DES_STAT((addr), (mask), (shift), (port), STATS_GROUP_COUNTERS, field, 0)
+
+/* VIDEO_RX8 of a pipe */
+#define DES_STAT_VIDEO_RX8(addr, port) \
+    DES_STAT_BIT((addr), 7, (port), video_rx_blk_len_err_flag), \
+    DES_STAT_BIT((addr), 6, (port), video_pipeline_locked_flag), \
+    DES_STAT_BIT((addr), 5, (port), sufficient_video_rx_thr_flag), \
+    DES_STAT_BIT((addr), 4, (port), video_seq_error_flag)
+
+/* Status, error and counter registers */
+static const regcache_range max96714_volatile_regs[] = {
+    { 0x0010, 0x0010, 0xA0, 0xA0 },   /* Reset one-shot, reset all */
+    { 0x0013, 0x0013, REGCACHE_VOLATILE },
+    { 0x0019, 0x001F, REGCACHE_VOLATILE },
+    { 0x0022, 0x0027, REGCACHE_VOLATILE },
+    { 0x011A, 0x011A, REGCACHE_VOLATILE },
+    { 0x011C, 0x011C, REGCACHE_VOLATILE },
+    { 0x0308, 0x0308, REGCACHE_VOLATILE },
+    { 0x0341, 0x0345, REGCACHE_VOLATILE },
+};
+
+static const regcache_range max96792_volatile_regs[] = {
+    { 0x0010, 0x0010, 0xA0, 0xA0 },   /* Reset one-shot, reset all */
+    { 0x0013, 0x0013, REGCACHE_VOLATILE },
+    { 0x0019, 0x001F, REGCACHE_VOLATILE },
+    { 0x0022, 0x0027, REGCACHE_VOLATILE },
+    { 0x011A, 0x011A, REGCACHE_VOLATILE },
+    { 0x011C, 0x011C, REGCACHE_VOLATILE },
+    { 0x012C, 0x012C, REGCACHE_VOLATILE },
+    { 0x012E, 0x012E, REGCACHE_VOLATILE },
+    { 0x0308, 0x0308, REGCACHE_VOLATILE },
+    { 0x0341, 0x0345, REGCACHE_VOLATILE },
+};
+
+static const regcache_range max96724_volatile_regs[] = {
+    { 0x000A, 0x000C, REGCACHE_VOLATILE },
+    { 0x0018, 0x0018, 0x0F, 0x0F },   /* Reset one-shot A~D */
+    { 0x001A, 0x001A, REGCACHE_VOLATILE },
+    { 0x0022, 0x002A, REGCACHE_VOLATILE },
+    { 0x0040, 0x0043, REGCACHE_VOLATILE },
+    { 0x0108, 0x0108, REGCACHE_VOLATILE },
+    { 0x011A, 0x011A, REGCACHE_VOLATILE },
+    { 0x012C, 0x012C, REGCACHE_VOLATILE },
+    { 0x013E, 0x013E, REGCACHE_VOLATILE },
+    { 0x0400, 0x0400, REGCACHE_VOLATILE },
+    { 0x040A, 0x040A, REGCACHE_VOLATILE },
+    { 0x08D0, 0x08D3, REGCACHE_VOLATILE },
+};
+
+/* Stats registers, per TX port */
+static const reg_stats_entry max96714_stats[] = {
+    DES_STAT(0x0013, 0x01, 2, 0, STATS_GROUP_FLAGS, global_status, STATS_REG_ERROR),    /* CTRL3: ERROR */
+    DES_STAT_BIT(0x001B, 5, 0, remote_error_flag),
+    DES_STAT_BIT(0x001F, 3, 0, lcrc_error_flag),
+    DES_STAT_VIDEO_RX8(0x011A, 0),
+    DES_STAT_BIT(0x011C, 7, 0, video_rx_overflow_flag),
+    DES_STAT_BIT(0x0341, 0, 0, video_rx_tun_overflow_flag),
+    DES_STAT_BIT(0x0474, 0, 0, video_tunnel_flag),
+    DES_STAT_CNT(0x0342, 0x0F, 0, 0, csi2_tx_packets_count),
+    DES_STAT_CNT(0x0344, 0x0F, 4, 0, mipi_phy_packets_count),
+    DES_STAT_CNT(0x0025, 0xFF, 0, 0, global_pkt_count),
+};
+
+static const reg_stats_entry max96792_stats[] = {
+    DES_STAT(0x0013, 0x01, 2, 0, STATS_GROUP_FLAGS, global_status, STATS_REG_ERROR),    /* CTRL3: ERROR */
+    DES_STAT_BIT(0x001B, 5, 0, remote_error_flag),
+    DES_STAT_VIDEO_RX8(0x011A, 0),
+    DES_STAT_VIDEO_RX8(0x012C, 1),
+    DES_STAT_BIT(0x011C, 7, 0, video_rx_overflow_flag),
+    DES_STAT_BIT(0x012E, 7, 1, video_rx_overflow_flag),
+    DES_STAT_BIT(0x0341, 0, 0, video_rx_tun_overflow_flag),
+    DES_STAT_BIT(0x0474, 0, 0, video_tunnel_flag),
+    DES_STAT_CNT(0x0342, 0x0F, 0, 0, csi2_tx_packets_count),
+    DES_STAT_CNT(0x0342, 0x0F, 4, 1, csi2_tx_packets_count),
+    DES_STAT_CNT(0x0344, 0xFF, 0, 0, mipi_phy_packets_count),
+    DES_STAT_CNT(0x0345, 0xFF, 0, 1, mipi_phy_packets_count),
+    DES_STAT_CNT(0x0025, 0xFF, 0, 0, global_pkt_count),
+};
+
+/* Pipe n carries link n, in error while the link is not locked either */
+#define DES_STAT_MAX9672X_STATUS(lock_reg, port) \
+    DES_STAT(0x001A, 0x01, 2, (port), STATS_GROUP_FLAGS, global_status, STATS_REG_ERROR), \
+    DES_STAT((lock_reg), 0x01, 3, (port), STATS_GROUP_FLAGS, global_status, \
+            STATS_REG_INVERT | STATS_REG_ERROR | STATS_REG_OR)
+
+static const reg_stats_entry max96724_stats[] = {
+    /* CTRL3: ERROR; LOCKED in CTRL3, CTRL12, CTRL13, CTRL14 */
+    DES_STAT_MAX9672X_STATUS(0x001A, 0),
+    DES_STAT_MAX9672X_STATUS(0x000A, 1),
+    DES_STAT_MAX9672X_STATUS(0x000B, 2),
+    DES_STAT_MAX9672X_STATUS(0x000C, 3),
+    DES_STAT_BIT(0x002A, 1, 0, remote_error_flag),
+    /* Pipes X, Y, Z, U */
+    DES_STAT_VIDEO_RX8(0x0108, 0),
+    DES_STAT_VIDEO_RX8(0x011A, 1),
+    DES_STAT_VIDEO_RX8(0x012C, 2),
+    DES_STAT_VIDEO_RX8(0x013E, 3),
+    DES_STAT_BIT(0x040A, 4, 0, video_rx_overflow_flag),
+    DES_STAT_BIT(0x040A, 5, 1, video_rx_overflow_flag),
+    DES_STAT_BIT(0x040A, 6, 2, video_rx_overflow_flag),
+    DES_STAT_BIT(0x040A, 7, 3, video_rx_overflow_flag),
+    /* CSI2 TX and MIPI PHY packet counters */
+    DES_STAT_CNT(0x08D0, 0x0F, 0, 0, csi2_tx_packets_count),
+    DES_STAT_CNT(0x08D0, 0x0F, 4, 1, csi2_tx_packets_count),
+    DES_STAT_CNT(0x08D1, 0x0F, 0, 2, csi2_tx_packets_count),
+    DES_STAT_CNT(0x08D1, 0x0F, 4, 3, csi2_tx_packets_count),
+    DES_STAT_CNT(0x08D2, 0x0F, 0, 0, mipi_phy_packets_count),
+    DES_STAT_CNT(0x08D2, 0x0F, 4, 1, mipi_phy_packets_count),
+    DES_STAT_CNT(0x08D3, 0x0F, 0, 2, mipi_phy_packets_count),
+    DES_STAT_CNT(0x08D3, 0x0F, 4, 3, mipi_phy_packets_count),
+    /* Packet counters A~D */
+    DES_STAT_CNT(0x0040, 0xFF, 0, 0, global_pkt_count),
+    DES_STAT_CNT(0x0041, 0xFF, 0, 1, global_pkt_count),
+    DES_STAT_CNT(0x0042, 0xFF, 0, 2, global_pkt_count),
+    DES_STAT_CNT(0x0043, 0xFF, 0, 3, global_pkt_count),
+};
+
+/* Packet counters, per TX port */
+static const stats_counter_desc max96714_counters[] = {
+    DES_COUNTER("pkt", global_pkt_count, 8, 0),             /* 0x0025 */
+    DES_COUNTER("csi_tx", csi2_tx_packets_count, 4, 0),     /* 0x0342 */
+    DES_COUNTER("phy", mipi_phy_packets_count, 4, 0),       /* 0x0344 */
+};
+
+static const stats_counter_desc max96792_counters[] = {
+    DES_COUNTER("pkt", global_pkt_count, 8, COUNTER_CLEARED),   /* 0x0025, written 0 after reading */
+    DES_COUNTER("csi_tx", csi2_tx_packets_count, 4, 0),     /* 0x0342 */
+    DES_COUNTER("phy", mipi_phy_packets_count, 8, 0),       /* 0x0344, 0x0345 */
+};
+
+static const stats_counter_desc max96724_counters[] = {
+    DES_COUNTER("pkt", global_pkt_count, 8, 0),             /* 0x0040 - 0x0043 */
+    DES_COUNTER("csi_tx", csi2_tx_packets_count, 4, 0),     /* 0x08D0, 0x08D1 */
+    DES_COUNTER("phy", mipi_phy_packets_count, 4, 0),       /* 0x08D2, 0x08D3 */
+};
+
 const deserializer_entry deserializers[] = {
   /* MAX96714 */
   {
     .deser_devid           = 0xC9,
     .deser_name            = "MAX96714",
     .tx_ports              = 1,
+    .csi_ports             = 1,
+    .lock_reg              = 0x0013,
+    .volatile_regs         = max96714_volatile_regs,
+    .num_volatile_regs     = ARRAY_SIZE(max96714_volatile_regs),
+    .stats                 = max96714_stats,
+    .num_stats             = ARRAY_SIZE(max96714_stats),
+    .counters              = max96714_counters,
+    .num_counters          = ARRAY_SIZE(max96714_counters),
     .init                  = max96714_init,
     .start                 = max96714_start,
     .set_mipi_tx_params    = max96714_set_mipi_tx_params,
@@ -38,6 +194,14 @@ const deserializer_entry deserializers[] = {
     .deser_devid           = 0xB6,
     .deser_name            = "MAX96792",
     .tx_ports              = 2,
+    .csi_ports             = 2,
+    .lock_reg              = 0x0013,
+    .volatile_regs         = max96792_volatile_regs,
+    .num_volatile_regs     = ARRAY_SIZE(max96792_volatile_regs),
+    .stats                 = max96792_stats,
+    .num_stats             = ARRAY_SIZE(max96792_stats),
+    .counters              = max96792_counters,
+    .num_counters          = ARRAY_SIZE(max96792_counters),
     .init                  = max96792_init,
     .start                 = max96792_start,
     .set_mipi_tx_params    = max96792_set_mipi_tx_params,
@@ -51,26 +215,46 @@ const deserializer_entry deserializers[] = {
     .deser_devid           = 0xA0,
     .deser_name            = "MAX96712",
     .tx_ports              = 4,
-    .init                  = max96714_init,
-    .start                 = max96714_start,
-    .set_mipi_tx_params    = max96714_set_mipi_tx_params,
-    .reset_link            = max96714_reset_link,
-    .wait_for_link         = max96714_wait_for_link,
-    .set_link_speed_gbps   = max96714_set_link_speed_gbps,
-    .get_stats             = max96714_get_stats,
+    .csi_ports             = 2,
+    .links                 = 4,
+    .lock_reg              = 0x001A,
+    .volatile_regs         = max96724_volatile_regs,
+    .num_volatile_regs     = ARRAY_SIZE(max96724_volatile_regs),
+    .stats                 = max96724_stats,
+    .num_stats             = ARRAY_SIZE(max96724_stats),
+    .counters              = max96724_counters,
+    .num_counters          = ARRAY_SIZE(max96724_counters),
+    .init                  = max96712_init,
+    .start                 = max96712_start,
+    .set_mipi_tx_params    = max96712_set_mipi_tx_params,
+    .reset_link            = max96712_reset_link,
+    .wait_for_link         = max96712_wait_for_link,
+    .set_link_speed_gbps   = max96712_set_link_speed_gbps,
+    .get_link_status       = max96712_get_link_status,
+    .select_link           = max96712_select_link,
   },
   /* MAX96724 */
   {
     .deser_devid           = 0xA2,
     .deser_name            = "MAX96724",
     .tx_ports              = 4,
+    .csi_ports             = 2,
+    .links                 = 4,
+    .lock_reg              = 0x001A,
+    .volatile_regs         = max96724_volatile_regs,
+    .num_volatile_regs     = ARRAY_SIZE(max96724_volatile_regs),
+    .stats                 = max96724_stats,
+    .num_stats             = ARRAY_SIZE(max96724_stats),
+    .counters              = max96724_counters,
+    .num_counters          = ARRAY_SIZE(max96724_counters),
     .init                  = max96724_init,
     .start                 = max96724_start,
     .set_mipi_tx_params    = max96724_set_mipi_tx_params,
     .reset_link            = max96724_reset_link,
     .wait_for_link         = max96724_wait_for_link,
     .set_link_speed_gbps   = max96724_set_link_speed_gbps,
-    .get_stats             = max96724_get_stats,
+    .get_link_status       = max96724_get_link_status,
+    .select_link           = max96724_select_link,
   },
 };
 
@@ -79,38 +263,99 @@ const uint8_t deserializer_default_i2c_slave[] =
   0x6AU, 0x27, 0x28U, 0x29
 };
 
-/* Variables */
-static deserializer_ctx deser_content;
-static int found_inx_deser = -1;
+int deserializer_read_reg(pdeserializer_ctx pctx, uint16_t reg_addr, uint8_t *buf)
+{
+    return regcache_read_reg8a16(pctx->bus, pctx->regcache, pctx->i2c_slave_address, reg_addr, buf);
+}
+
+int deserializer_read_burst(pdeserializer_ctx pctx, uint16_t reg_addr, uint8_t *buf, size_t length)
+{
+    return regcache_read_burst8a16(pctx->bus, pctx->regcache, pctx->i2c_slave_address, reg_addr, buf, length);
+}
+
+int deserializer_read_regs(pdeserializer_ctx pctx, const uint16_t *reg_addr, uint8_t *buf, int count)
+{
+    return regcache_read_regs8a16(pctx->bus, pctx->regcache, pctx->i2c_slave_address, reg_addr, buf, count);
+}
+
+int deserializer_write_reg(pdeserializer_ctx pctx, uint16_t reg_addr, uint8_t value)
+{
+    return regcache_write_reg8a16(pctx->bus, pctx->regcache, pctx->i2c_slave_address, reg_addr, value);
+}
+
+void deserializer_settle(pdeserializer_ctx pctx, unsigned int delay_us)
+{
+    if (regcache_settle_needed(pctx->regcache))
+        time_sleep_us(pctx->bus, delay_us);
+}
+
+/**
+ * Settle delay cut short by a status register: returns as soon as
+ * (reg & mask) == value, delay_us bounds the wait. Zero mask - plain delay.
+ * */
+void deserializer_settle_ready(pdeserializer_ctx pctx, uint16_t reg_addr, uint8_t mask, uint8_t value,
+        unsigned int delay_us)
+{
+    if (regcache_settle_needed(pctx->regcache) == 0)
+        return;
+
+    if (mask == 0)
+    {
+        time_sleep_us(pctx->bus, delay_us);
+        return;
+    }
+
+    poll_reg8a16(pctx->bus, pctx->i2c_slave_address, reg_addr, mask, value, (delay_us + 999) / 1000, NULL);
+}
+
+int deserializer_poll_reg(pdeserializer_ctx pctx, uint16_t reg_addr, uint8_t mask, uint8_t value,
+        unsigned int timeout_ms, unsigned int *elapsed_ms)
+{
+    return poll_reg8a16(pctx->bus, pctx->i2c_slave_address, reg_addr, mask, value, timeout_ms, elapsed_ms);
+}
+
+int deserializer_run_seq(pdeserializer_ctx pctx, const reg_seq_entry *seq, int count)
+{
+    return reg_seq_run(pctx->bus, pctx->regcache, pctx->i2c_slave_address, seq, count);
+}
+
+/**
+ * Read the stats table of the chip for the groups
+ * */
+int deserializer_read_stats(pdeserializer_ctx pctx, uint32_t groups)
+{
+    return reg_stats_read(pctx->bus, pctx->regcache, pctx->i2c_slave_address, pctx->stats, pctx->num_stats,
+            groups, pctx->deser_stats, sizeof(deserializer_stats));
+}
 
-static int deserializer_search_chip(void)
+int deserializer_search_chip(pserdes_chain pchain)
 {
     uint8_t reg8 = 0, sa_deser = 0;
     int i;
 
-    if (found_inx_deser >= 0) return 0;
+    if (pchain->found_inx_deser >= 0) return 0;
 
-    if (app_params.deser_i2c_sa == 0)
+    if (pchain->deser_i2c_sa == 0)
     {
         for (i = 0; i < ARRAY_SIZE(deserializer_default_i2c_slave); i++)
         {
             sa_deser = deserializer_default_i2c_slave[i];
 
-            if (i2c_read_reg8a16(sa_deser, 0x000D, &reg8) == 0)
+            if (i2c_read_reg8a16(&pchain->bus, sa_deser, 0x000D, &reg8) == 0)
             {
-                deser_content.i2c_slave_address = sa_deser;
+                pchain->deser_content.i2c_slave_address = sa_deser;
                 break;
             }
         }
     } else {
-        sa_deser = app_params.deser_i2c_sa;
+        sa_deser = pchain->deser_i2c_sa;
 
-        if (i2c_read_reg8a16(sa_deser, 0x000D, &reg8) < 0)
+        if (i2c_read_reg8a16(&pchain->bus, sa_deser, 0x000D, &reg8) < 0)
         {
             goto deserializer_search_chip_end;
         }
 
-        deser_content.i2c_slave_address = sa_deser;
+        pchain->deser_content.i2c_slave_address = sa_deser;
     }
 
     for (i = 0; i < ARRAY_SIZE(deserializers); i++)
@@ -118,186 +363,444 @@ static int deserializer_search_chip(void)
         if (reg8 == deserializers[i].deser_devid)
         {
             /* Found */
-            found_inx_deser = i;
+            pchain->found_inx_deser = i;
+            pchain->num_links = (deserializers[i].links > 1) ? deserializers[i].links : 1;
+            pchain->deser_content.stats = deserializers[i].stats;
+            pchain->deser_content.num_stats = deserializers[i].num_stats;
+
+            if ((app_params.reg_cache != 0) || (app_params.delta_mode != 0))
+            {
+                pchain->deser_content.regcache = regcache_create(deserializers[i].volatile_regs,
+                        deserializers[i].num_volatile_regs);
+                if (pchain->deser_content.regcache != NULL)
+                    pchain->deser_content.regcache->delta = app_params.delta_mode;
+            }
             break;
         }
     }
 
 deserializer_search_chip_end:
-    return (found_inx_deser >= 0) ? 0 : -1;
+    return (pchain->found_inx_deser >= 0) ? 0 : -1;
 }
 
-int deserializer_init(void)
+int deserializer_init(pserdes_chain pchain)
 {
     int ret = 0;
 
-    deserializer_search_chip();
+    deserializer_search_chip(pchain);
 
-    if (found_inx_deser < 0) return -1;
+    if (pchain->found_inx_deser < 0) return -1;
 
-    ret = deserializers[found_inx_deser].init(&deser_content);
+    ret = deserializers[pchain->found_inx_deser].init(&pchain->deser_content);
     if (ret < 0)
         return ret;
 
     if (ret == 0)
     {
-        printf("Found deserializer %s\r\n", deserializers[found_inx_deser].deser_name);
+        printf("Found deserializer %s\r\n", deserializers[pchain->found_inx_deser].deser_name);
     }
 
     return ret;
 }
 
-int deserializer_search_for_serializer(void)
+static int deserializer_try_speed(void *arg, int speed)
 {
+    pserdes_chain pchain = (pserdes_chain)arg;
     int ret = 0;
 
-    if (found_inx_deser < 0) return -1;
+    ret = deserializers[pchain->found_inx_deser].set_link_speed_gbps(&pchain->deser_content, speed);
+    if (ret < 0) return ret;
 
-    if (deser_content.features & FEATURE_DES_12GBPS)
-    {
-        ret = deserializers[found_inx_deser].set_link_speed_gbps(&deser_content, 12);
-        if (ret < 0)
-        {
-            ret = deserializers[found_inx_deser].set_link_speed_gbps(&deser_content, 6);
-            if (ret < 0)
-            {
-                ret = deserializers[found_inx_deser].set_link_speed_gbps(&deser_content, 3);
-            }
-        }
-    } else if (deser_content.features & FEATURE_DES_6GBPS)
+    return deserializers[pchain->found_inx_deser].wait_for_link(&pchain->deser_content);
+}
+
+/**
+ * Find the rate the serializer of the link runs at, preferred one is
+ * tried first, then the last good one of that serializer
+ * */
+int deserializer_negotiate_link(pserdes_chain pchain, int link, int preferred)
+{
+    int pref[2], ret = 0;
+
+    if (pchain->found_inx_deser < 0) return -1;
+
+    pref[0] = preferred;
+    pref[1] = link_state_load(pchain->bus.bus_num, pchain->deser_content.i2c_slave_address,
+            serializer_get_devid(pchain, link));
+
+    ret = link_neg_run(pchain->deser_content.features, pref, ARRAY_SIZE(pref),
+            deserializer_try_speed, pchain);
+    if (ret < 0) return ret;
+
+    pchain->deser_content.link_speed = ret;
+
+    return 0;
+}
+
+int deserializer_search_for_serializer(pserdes_chain pchain)
+{
+    int ret = 0;
+
+    if (pchain->found_inx_deser < 0) return -1;
+
+    /* Re-applied config: keep the running link */
+    if ((app_params.delta_mode != 0) && (deserializer_link_locked(pchain) > 0))
     {
-        ret = deserializers[found_inx_deser].set_link_speed_gbps(&deser_content, 6);
-        if (ret < 0)
-        {
-            ret = deserializers[found_inx_deser].set_link_speed_gbps(&deser_content, 3);
-        }
-    } else if (deser_content.features & FEATURE_DES_3GBPS) {
-        ret = deserializers[found_inx_deser].set_link_speed_gbps(&deser_content, 3);
+        printf("Link with serializer is OK\r\n");
+        return 0;
     }
+
+    ret = deserializer_negotiate_link(pchain, 0, 0);
     if (ret < 0) return ret;
 
-    ret = deserializers[found_inx_deser].wait_for_link(&deser_content);
-    if (ret < 0)
+    /* Serializer is reachable now, the rate is kept for its device ID */
+    if (serializer_search_chip(pchain, 0) == 0)
+        link_state_save(pchain->bus.bus_num, pchain->deser_content.i2c_slave_address,
+                serializer_get_devid(pchain, 0), pchain->deser_content.link_speed);
+
+    printf("Link with serializer is OK at %dG, locked in %u ms\r\n",
+            pchain->deser_content.link_speed, pchain->deser_content.link_lock_ms);
+
+    return ret;
+}
+
+/* State of a multi-link bring-up */
+typedef struct deserializer_links_arg_ {
+    pserdes_chain   pchain;
+    int             speed;
+    uint8_t         pending;
+    uint8_t         locked;     /* Locked since the last poll_until() */
+} deserializer_links_arg;
+
+/**
+ * Ends the poll as soon as any pending link locks
+ * */
+static int deserializer_links_locked(void *arg)
+{
+    deserializer_links_arg *parg = (deserializer_links_arg *)arg;
+    pserdes_chain pchain = parg->pchain;
+    uint8_t locked = 0;
+    int link;
+
+    if (deserializers[pchain->found_inx_deser].get_link_status(&pchain->deser_content, &locked) < 0)
+        return 0;
+
+    locked &= parg->pending;
+    parg->pending &= ~locked;
+    parg->locked |= locked;
+
+    for (link = 0; link < pchain->num_links; link++)
     {
-        /* Set lowest rate */
-        if (deser_content.features & FEATURE_DES_6GBPS)
+        if (!(locked & (1 << link)))
+            continue;
+
+        pchain->links[link].locked = 1;
+        pchain->links[link].speed = parg->speed;
+        pchain->links[link].lock_ms =
+                (unsigned int)((time_monotonic_us(&pchain->bus) - pchain->start_us) / 1000);
+
+        if (parg->speed != 0)
+            printf("Link %c locked at %dG\r\n", 'A' + link, parg->speed);
+        else
+            printf("Link %c locked\r\n", 'A' + link);
+    }
+
+    return (locked != 0);
+}
+
+/**
+ * Bring up all links of a multi-link deserializer. Links still down train
+ * together at each rate and link_up() is called for a link as soon as it
+ * locks, while the others keep training. Each rate gets its share of
+ * LINK_WAIT_TIME_MS, but once a link has locked the others get only
+ * LINK_LOCK_WINDOW_MS after the last lock and no further rates are tried,
+ * so absent links do not cost the whole wait. With --noinit the rate is
+ * left as it is and the links get one lock window.
+ * Returns the number of links that locked.
+ * */
+int deserializer_search_for_serializers(pserdes_chain pchain,
+        void (*link_up)(pserdes_chain pchain, int link))
+{
+    const deserializer_entry *pentry;
+    deserializer_links_arg arg;
+    int speeds[LINK_NEG_MAX_RATES], num_speeds, pref, num_up = 0, i, link;
+    uint64_t now_us, end_us;
+
+    if (pchain->found_inx_deser < 0) return -1;
+
+    pentry = &deserializers[pchain->found_inx_deser];
+    if (pentry->get_link_status == NULL) return -1;
+
+    if (app_params.no_init != 0)
+    {
+        /* Rate unknown */
+        speeds[0] = 0;
+        num_speeds = 1;
+    } else {
+        /* Serializers are not reachable yet, start with the rate of the last one seen */
+        pref = link_state_load(pchain->bus.bus_num, pchain->deser_content.i2c_slave_address, 0);
+        num_speeds = link_neg_order(pchain->deser_content.features, &pref, 1, speeds);
+    }
+
+    arg.pchain = pchain;
+    arg.pending = (1 << pchain->num_links) - 1;
+
+    for (i = 0; (i < num_speeds) && (arg.pending != 0) && (num_up == 0); i++)
+    {
+        arg.speed = speeds[i];
+
+        pchain->deser_content.link_mask = arg.pending;
+        if ((speeds[i] != 0) && (pentry->set_link_speed_gbps(&pchain->deser_content, speeds[i]) < 0))
+            continue;
+
+        end_us = time_monotonic_us(&pchain->bus) + ((speeds[i] != 0) ?
+                (uint64_t)LINK_WAIT_TIME_MS * 1000 / num_speeds : (uint64_t)LINK_LOCK_WINDOW_MS * 1000);
+
+        while ((arg.pending != 0) && ((now_us = time_monotonic_us(&pchain->bus)) < end_us))
         {
-            ret = deserializers[found_inx_deser].set_link_speed_gbps(&deser_content, 6);
-            if (ret < 0) return ret;
-        } else if (deser_content.features & FEATURE_DES_3GBPS) {
-            ret = deserializers[found_inx_deser].set_link_speed_gbps(&deser_content, 3);
-            if (ret < 0) return ret;
+            arg.locked = 0;
+            poll_until(&pchain->bus, deserializer_links_locked, &arg,
+                    (unsigned int)((end_us - now_us + 999) / 1000), NULL);
+
+            if (arg.locked == 0)
+                continue;
+
+            /* Links still down get one more lock window */
+            now_us = time_monotonic_us(&pchain->bus);
+            if (end_us > now_us + (uint64_t)LINK_LOCK_WINDOW_MS * 1000)
+                end_us = now_us + (uint64_t)LINK_LOCK_WINDOW_MS * 1000;
+
+            /* Serializer setup outside of the poll, links still down keep training */
+            for (link = 0; link < pchain->num_links; link++)
+            {
+                if (!(arg.locked & (1 << link)))
+                    continue;
+
+                num_up++;
+
+                if ((serializer_search_chip(pchain, link) == 0) && (arg.speed != 0))
+                    link_state_save(pchain->bus.bus_num, pchain->deser_content.i2c_slave_address,
+                            serializer_get_devid(pchain, link), arg.speed);
+
+                link_up(pchain, link);
+            }
+
+            pchain->deser_content.link_mask = arg.pending;
         }
-        //ret = deserializers[found_inx_deser].wait_for_link(&deser_content);
-        //if (ret < 0) return ret;
     }
-    ret = deserializers[found_inx_deser].wait_for_link(&deser_content);
-    if (ret < 0)
+
+    pchain->deser_content.link_mask = 0;
+
+    for (i = 0; i < pchain->num_links; i++)
     {
-        if (deser_content.features & FEATURE_DES_3GBPS)
+        if (arg.pending & (1 << i))
         {
-            /* Set 3Gbps rate */
-            ret = deserializers[found_inx_deser].set_link_speed_gbps(&deser_content, 3);
-            if (ret < 0) return ret;
-            ret = deserializers[found_inx_deser].wait_for_link(&deser_content);
+            printf("Link %c: no serializer\r\n", 'A' + i);
+            continue;
         }
+
+        if (pchain->deser_content.link_speed == 0)
+            pchain->deser_content.link_speed = pchain->links[i].speed;
     }
-    
-    if (ret >= 0)
-        printf("Link with serializer is OK\r\n");
 
-    return ret;
+    return num_up;
 }
 
-uint32_t deserializer_get_features(void)
+/**
+ * Reach the serializer of one link only, -1 - of all links
+ * */
+int deserializer_select_link(pserdes_chain pchain, int link)
 {
-    if (found_inx_deser < 0) return 0;
-    return deser_content.features;
+    if (pchain->found_inx_deser < 0) return -1;
+
+    if (deserializers[pchain->found_inx_deser].select_link == NULL) return 0;
+
+    return deserializers[pchain->found_inx_deser].select_link(&pchain->deser_content, link);
 }
 
-int deserializer_set_link_speed(int speed)
+int deserializer_link_locked(pserdes_chain pchain)
 {
+    uint8_t reg8 = 0, mask;
     int ret = 0;
 
-    if (found_inx_deser < 0) return -1;
+    if (pchain->found_inx_deser < 0) return -1;
 
-    ret = deserializers[found_inx_deser].set_link_speed_gbps(&deser_content, speed);
-    if (ret < 0) return ret;
+    if (deserializers[pchain->found_inx_deser].get_link_status != NULL)
+    {
+        mask = pchain->deser_content.link_mask;
+        if (mask == 0)
+            mask = (1 << pchain->num_links) - 1;
+
+        ret = deserializers[pchain->found_inx_deser].get_link_status(&pchain->deser_content, &reg8);
+        if (ret < 0) return ret;
 
-    ret = deserializers[found_inx_deser].wait_for_link(&deser_content);
+        return ((reg8 & mask) == mask) ? 1 : 0;
+    }
+
+    ret = deserializer_read_reg(&pchain->deser_content, deserializers[pchain->found_inx_deser].lock_reg, &reg8);
     if (ret < 0) return ret;
 
-    return ret;
+    return (reg8 & 0x08) ? 1 : 0;
+}
+
+uint8_t deserializer_get_i2c_address(pserdes_chain pchain)
+{
+    return pchain->deser_content.i2c_slave_address;
+}
+
+const char *deserializer_get_name(pserdes_chain pchain)
+{
+    if (pchain->found_inx_deser < 0) return NULL;
+    return deserializers[pchain->found_inx_deser].deser_name;
+}
+
+uint32_t deserializer_get_features(pserdes_chain pchain)
+{
+    if (pchain->found_inx_deser < 0) return 0;
+    return pchain->deser_content.features;
 }
 
-int deserializer_start(void)
+int deserializer_set_link_speed(pserdes_chain pchain, int speed)
 {
     int ret = 0;
 
-    if (found_inx_deser < 0) return -1;
+    if (pchain->found_inx_deser < 0) return -1;
 
-    ret = deserializers[found_inx_deser].set_mipi_tx_params(&deser_content,
-        0, app_params.mipi_tx_lanes,
-        app_params.mipi_tx_map,
-        app_params.mipi_tx_pol,
-        app_params.mipi_tx_deskew_en,
-        app_params.mipi_tx_out_freq, 1);
+    ret = deserializer_try_speed(pchain, speed);
     if (ret < 0) return ret;
 
-    ret = deserializers[found_inx_deser].start(&deser_content);
+    pchain->deser_content.link_speed = speed;
+
+    return ret;
+}
+
+int deserializer_start(pserdes_chain pchain)
+{
+    int ret = 0, port;
+
+    if (pchain->found_inx_deser < 0) return -1;
+
+    profile_phase(&pchain->bus, "mipi_setup");
+
+    /* Port 0 first, it also sets up what the ports share */
+    for (port = 0; port < deserializers[pchain->found_inx_deser].csi_ports; port++)
+    {
+        ret = deserializers[pchain->found_inx_deser].set_mipi_tx_params(&pchain->deser_content,
+            port, app_params.mipi_tx_lanes[port],
+            app_params.mipi_tx_map[port],
+            app_params.mipi_tx_pol[port],
+            app_params.mipi_tx_deskew_en,
+            app_params.mipi_tx_out_freq[port], 1);
+        if (ret < 0) return ret;
+    }
+
+    profile_phase(&pchain->bus, "deserializer_start");
+
+    ret = deserializers[pchain->found_inx_deser].start(&pchain->deser_content);
     if (ret < 0) return ret;
 
     return ret;
 }
 
-int deserializer_get_stat(void)
+/**
+ * Driver hook when the chip needs more than its stats table
+ * */
+static int deserializer_update_stats(pserdes_chain pchain, uint32_t groups)
+{
+    const deserializer_entry *pentry = &deserializers[pchain->found_inx_deser];
+
+    if (pentry->get_stats != NULL)
+        return pentry->get_stats(&pchain->deser_content, groups);
+
+    return deserializer_read_stats(&pchain->deser_content, groups);
+}
+
+int deserializer_get_stat(pserdes_chain pchain)
 {
     int i;
 
-    deserializers[found_inx_deser].get_stats(&deser_content);
+    deserializer_update_stats(pchain, STATS_GROUP_ALL);
 
     printf("======== Statistics [Des] ================\r\n");
 
-    for (i = 0; i < deserializers[found_inx_deser].tx_ports; i++)
+    /* The ports deserializer_start() set up */
+    for (i = 0; i < deserializers[pchain->found_inx_deser].csi_ports; i++)
     {
         printf("Stats of MIPI TX channel #%d\r\n", i);
 
         printf("Status: %s\r\n",
-                (deser_content.deser_stats[i].global_status == -1) ? "Error" : "OK");
+                (pchain->deser_content.deser_stats[i].global_status == -1) ? "Error" : "OK");
 
-        if (deser_content.deser_stats[i].remote_error_flag)
+        if (pchain->deser_content.deser_stats[i].remote_error_flag)
             printf("Remote error detected\r\n");
 
-        if (deser_content.deser_stats[i].video_rx_blk_len_err_flag)
+        if (pchain->deser_content.deser_stats[i].video_rx_blk_len_err_flag)
             printf("Video Rx block-length error detected\r\n");
 
-        if (deser_content.deser_stats[i].video_pipeline_locked_flag)
+        if (pchain->deser_content.deser_stats[i].video_pipeline_locked_flag)
             printf("Video pipeline locked\r\n");
 
-        if (deser_content.deser_stats[i].video_rx_overflow_flag)
+        if (pchain->deser_content.deser_stats[i].video_rx_overflow_flag)
             printf("Video RX overflow\r\n");
 
-        if (deser_content.deser_stats[i].video_rx_tun_overflow_flag)
+        if (pchain->deser_content.deser_stats[i].video_rx_tun_overflow_flag)
             printf("Video tunnel overflow\r\n");
 
-        if (deser_content.deser_stats[i].sufficient_video_rx_thr_flag)
+        if (pchain->deser_content.deser_stats[i].sufficient_video_rx_thr_flag)
             printf("Sufficient throughput detected\r\n");
 
-        if (deser_content.deser_stats[i].video_seq_error_flag)
+        if (pchain->deser_content.deser_stats[i].video_seq_error_flag)
             printf("Video Rx sequence error detected\r\n");
 
-        if (deser_content.deser_stats[i].lcrc_error_flag)
+        if (pchain->deser_content.deser_stats[i].lcrc_error_flag)
             printf("LCRC error detected\r\n");
 
         printf("Mode: %s\r\n",
-                deser_content.deser_stats[i].video_tunnel_flag ? "Tunnel" : "Pixel");
+                pchain->deser_content.deser_stats[i].video_tunnel_flag ? "Tunnel" : "Pixel");
 
-        printf("MIPI TX packets  : %d\r\n", deser_content.deser_stats[i].csi2_tx_packets_count);
+        printf("MIPI TX packets  : %d\r\n", pchain->deser_content.deser_stats[i].csi2_tx_packets_count);
 
-        printf("MIPI MIPI PHY out: %d\r\n", deser_content.deser_stats[i].mipi_phy_packets_count);
+        printf("MIPI MIPI PHY out: %d\r\n", pchain->deser_content.deser_stats[i].mipi_phy_packets_count);
 
-        printf("Packet counter   : %d\r\n", deser_content.deser_stats[i].global_pkt_count);
+        printf("Packet counter   : %d\r\n", pchain->deser_content.deser_stats[i].global_pkt_count);
     }
 
     return 0;
 }
+
+/**
+ * Read register groups of the stats of the deserializer for the monitor,
+ * TX port n is in deser_stats[n]. Returns its counters.
+ * */
+const stats_counter_desc *deserializer_sample_stats(pserdes_chain pchain, uint32_t groups,
+        int *num_counters, int *num_ports)
+{
+    const deserializer_entry *pentry;
+
+    if (pchain->found_inx_deser < 0) return NULL;
+
+    pentry = &deserializers[pchain->found_inx_deser];
+
+    deserializer_update_stats(pchain, groups);
+
+    *num_counters = pentry->num_counters;
+    *num_ports = pentry->tx_ports;
+
+    return pentry->counters;
+}
+
+void deserializer_exit(pserdes_chain pchain)
+{
+    if (pchain->deser_content.regcache != NULL)
+    {
+        printf("Deserializer register cache: %u hits, %u misses\r\n",
+                pchain->deser_content.regcache->hits, pchain->deser_content.regcache->misses);
+
+        if (pchain->deser_content.regcache->delta != 0)
+            printf("Deserializer delta mode: %u writes issued, %u elided\r\n",
+                    pchain->deser_content.regcache->writes, pchain->deser_content.regcache->elided);
+
+        regcache_destroy(pchain->deser_content.regcache);
+        pchain->deser_content.regcache = NULL;
+    }
+}
@@ -20,19 +20,146 @@
 #include <stdint.h>
 #include <linux/i2c.h>
 #include <linux/i2c-dev.h>
+#include "serdes_head.h"
 
-int i2c_fd = -1;
-struct i2c_rdwr_ioctl_data i2c_data;
+/* Longest auto-increment write */
+#define I2C_BURST_MAX           (64)
+
+static int i2c_dev_open(pi2c_bus pbus);
+static int i2c_dev_close(pi2c_bus pbus);
+static int i2c_dev_transfer(pi2c_bus pbus, struct i2c_msg *msgs, int nmsgs);
+
+/* /dev/i2c-N character device, the default transport */
+static const i2c_transport i2c_dev_transport = {
+    .name           = "i2c-dev",
+    .open           = i2c_dev_open,
+    .close          = i2c_dev_close,
+    .transfer       = i2c_dev_transfer,
+    .now_ns         = NULL,
+    .sleep_until_ns = NULL,
+    .priv           = NULL,
+};
+
+/* Transport of the buses opened from now on */
+static const i2c_transport *i2c_tp = &i2c_dev_transport;
+
+/**
+ * Single I2C_RDWR transfer
+ * */
+static int i2c_transfer(pi2c_bus pbus, struct i2c_msg *msgs, int nmsgs)
+{
+    unsigned int reads = 0, writes = 0, bytes = 0;
+    uint64_t start_ns = 0;
+    int ret = 0, i, err;
+
+    for (i = 0; i < nmsgs; i++)
+    {
+        bytes += msgs[i].len;
+
+        if (msgs[i].flags & I2C_M_RD)
+            reads++;
+        else if ((i + 1 < nmsgs) && (msgs[i + 1].flags & I2C_M_RD) &&
+                 (msgs[i + 1].addr == msgs[i].addr))
+            continue;   /* Register address of the read which follows */
+        else
+            writes++;
+    }
+
+    profile_count_i2c(pbus, reads, writes, bytes);
+
+    if (app_params.trace != 0)
+        start_ns = time_monotonic_ns(pbus);
+
+    ret = pbus->tp->transfer(pbus, msgs, nmsgs);
+
+    if (app_params.trace != 0)
+    {
+        err = (ret < 0) ? errno : 0;
+        trace_transfer(pbus, msgs, nmsgs, start_ns, time_monotonic_ns(pbus) - start_ns, ret, err);
+        errno = err;
+    }
+    if (ret < 0)
+    {
+        //printf("%s:%d I2C: transfer error:%s\n", __func__, __LINE__, strerror(errno));
+        return ret;
+    }
+    return 0;
+}
+
+/**
+ * Issue all queued messages as one I2C_RDWR ioctl
+ * */
+int i2c_batch_flush(pi2c_bus pbus)
+{
+    int ret = 0;
+
+    if (pbus->batch_nmsgs > 0)
+    {
+        ret = i2c_transfer(pbus, pbus->batch_msgs, pbus->batch_nmsgs);
+        if (ret < 0)
+            pbus->batch_error = ret;
+    }
+
+    pbus->batch_nmsgs = 0;
+    pbus->batch_pool_used = 0;
+
+    return ret;
+}
+
+/**
+ * Reserve room for messages in the queue, flushing it when full
+ * */
+static unsigned char *i2c_batch_reserve(pi2c_bus pbus, int nmsgs, size_t length)
+{
+    unsigned char *pbuf;
+
+    if (length > I2C_BATCH_POOL_SIZE)
+        return NULL;
+
+    if ((pbus->batch_nmsgs + nmsgs > I2C_BATCH_MAX_MSGS) ||
+        (pbus->batch_pool_used + length > I2C_BATCH_POOL_SIZE))
+    {
+        i2c_batch_flush(pbus);
+    }
+
+    pbuf = &pbus->batch_pool[pbus->batch_pool_used];
+    pbus->batch_pool_used += length;
+
+    return pbuf;
+}
+
+/**
+ * Queue a write message (copied into the queue pool)
+ * */
+static int i2c_batch_queue_write(pi2c_bus pbus,unsigned char dev_addr,unsigned char *pbuf,size_t length)
+{
+    unsigned char *pdst;
+    struct i2c_msg *message;
+
+    pdst = i2c_batch_reserve(pbus, 1, length);
+    if (pdst == NULL)
+        return -1;
+
+    memcpy(pdst, pbuf, length);
+
+    message = &pbus->batch_msgs[pbus->batch_nmsgs++];
+    message->addr = dev_addr;//Slave address
+    message->flags = 0;//Write
+    message->buf = pdst;
+    message->len = length;
+
+    return 0;
+}
 
 /**
  * i2c
  *
  * */
-int i2c_init(int i2c_bus_num)
+static int i2c_dev_open(pi2c_bus pbus)
 {
     int fd = 0, ret = 0;
     char i2c_dev_link[32] = "\0";
-    sprintf(i2c_dev_link, "/dev/i2c-%d", i2c_bus_num);
+    sprintf(i2c_dev_link, "/dev/i2c-%d", pbus->bus_num);
     if ((fd = open(i2c_dev_link, O_RDWR)) < 0)
     {
         printf("open %s failed:%s\n", i2c_dev_link, strerror(errno));
@@ -56,23 +183,66 @@ int i2c_init(int i2c_bus_num)
         close(fd);
         return -1;
     }
-    i2c_fd = fd;
+    pbus->fd = fd;
     return 0;
 }
 /**
  *
  * */
-int i2c_exit(void)
+static int i2c_dev_close(pi2c_bus pbus)
 {
-    if (i2c_fd > 0)
-        close(i2c_fd);
+    if (pbus->fd > 0)
+        close(pbus->fd);
+    pbus->fd = -1;
     return 0;
 }
 
+static int i2c_dev_transfer(pi2c_bus pbus, struct i2c_msg *msgs, int nmsgs)
+{
+    struct i2c_rdwr_ioctl_data i2c_data;
+
+    i2c_data.msgs = msgs;
+    i2c_data.nmsgs = nmsgs;
+
+    return ioctl(pbus->fd, I2C_RDWR, (unsigned long)&i2c_data);
+}
+
+/**
+ * Select the transport, before i2c_init()
+ * */
+void i2c_set_transport(const i2c_transport *ptp)
+{
+    i2c_tp = (ptp != NULL) ? ptp : &i2c_dev_transport;
+}
+
+const i2c_transport *i2c_get_transport(void)
+{
+    return i2c_tp;
+}
+
+/**
+ * Open a bus with the selected transport
+ * */
+int i2c_init(pi2c_bus pbus, int i2c_bus_num)
+{
+    memset(pbus, 0, sizeof(i2c_bus));
+    pbus->bus_num = i2c_bus_num;
+    pbus->fd = -1;
+    pbus->tp = i2c_tp;
+    pbus->profile.current = -1;
+
+    return pbus->tp->open(pbus);
+}
+
+int i2c_exit(pi2c_bus pbus)
+{
+    return pbus->tp->close(pbus);
+}
+
 /**
  * i2c read register
  * */
-int i2c_read_reg8a8(unsigned char dev_addr,unsigned char reg_addr,unsigned char *buf)
+int i2c_read_reg8a8(pi2c_bus pbus,unsigned char dev_addr,unsigned char reg_addr,unsigned char *buf)
 {
     int ret = 0;
     unsigned char buf_in[2]={reg_addr & 0xFF};
@@ -88,10 +258,9 @@ int i2c_read_reg8a8(unsigned char dev_addr,unsigned char reg_addr,unsigned char
     message[1].buf = buf;
     message[1].len = 1; // 1 byte of data
 
-    i2c_data.msgs = message;
-    i2c_data.nmsgs = 2;
+    i2c_batch_flush(pbus);
 
-    ret = ioctl(i2c_fd, I2C_RDWR, (unsigned long)&i2c_data);
+    ret = i2c_transfer(pbus, message, 2);
     if (ret < 0)
     {
         //printf("%s:%d I2C: read error:%s\n", __func__, __LINE__, strerror(errno));
@@ -103,7 +272,7 @@ int i2c_read_reg8a8(unsigned char dev_addr,unsigned char reg_addr,unsigned char
 /**
  * i2c read register
  * */
-int i2c_read_reg8a16(unsigned char dev_addr,unsigned short reg_addr,unsigned char *buf)
+int i2c_read_reg8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,unsigned char *buf)
 {
     int ret = 0;
     unsigned char buf_in[2]={(reg_addr >> 8) & 0xFF, reg_addr & 0xFF};
@@ -119,10 +288,9 @@ int i2c_read_reg8a16(unsigned char dev_addr,unsigned short reg_addr,unsigned cha
     message[1].buf = buf;
     message[1].len = 1; // 1 byte of data
 
-    i2c_data.msgs = message;
-    i2c_data.nmsgs = 2;
+    i2c_batch_flush(pbus);
 
-    ret = ioctl(i2c_fd, I2C_RDWR, (unsigned long)&i2c_data);
+    ret = i2c_transfer(pbus, message, 2);
     if (ret < 0)
     {
         //printf("%s:%d I2C: read error:%s\n", __func__, __LINE__, strerror(errno));
@@ -131,10 +299,41 @@ int i2c_read_reg8a16(unsigned char dev_addr,unsigned short reg_addr,unsigned cha
     return 0;
 }
 
+/**
+ * i2c burst read: 2-byte register address, then length bytes using
+ * the device address auto-increment
+ * */
+int i2c_read_burst8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,unsigned char *buf,size_t length)
+{
+    int ret = 0;
+    unsigned char buf_in[2]={(reg_addr >> 8) & 0xFF, reg_addr & 0xFF};
+    struct i2c_msg message[2];
+
+    message[0].addr = dev_addr;//Slave address
+    message[0].flags = 0;   //Write
+    message[0].buf = buf_in;//Register 2 bytes
+    message[0].len = 2;
+
+    message[1].addr = dev_addr;//Slave address
+    message[1].flags = I2C_M_RD; //Read
+    message[1].buf = buf;
+    message[1].len = length; // length bytes of data
+
+    i2c_batch_flush(pbus);
+
+    ret = i2c_transfer(pbus, message, 2);
+    if (ret < 0)
+    {
+        //printf("%s:%d I2C: burst read error:%s\n", __func__, __LINE__, strerror(errno));
+        return ret;
+    }
+    return 0;
+}
+
 /**
  * i2c Write reg
  * */
-int i2c_write_reg8a16(unsigned char dev_addr,unsigned short reg_addr,unsigned char value_byte)
+int i2c_write_reg8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,unsigned char value_byte)
 {
     int ret = 0;
     unsigned char buf[3]={0};
@@ -144,15 +343,17 @@ int i2c_write_reg8a16(unsigned char dev_addr,unsigned short reg_addr,unsigned ch
     buf[1] = reg_addr & 0xFF;//Low reg
     buf[2] = value_byte;//Reg value
 
+    if (pbus->batch_depth > 0)
+        return i2c_batch_queue_write(pbus, dev_addr, buf, 3);
+
     message.addr = dev_addr;//Slave address
     message.buf = buf;
     message.flags = 0;//Write
     message.len = 3;
 
-    i2c_data.msgs = &message;
-    i2c_data.nmsgs = 1;
+    i2c_batch_flush(pbus);
 
-    ret = ioctl(i2c_fd, I2C_RDWR,&i2c_data);
+    ret = i2c_transfer(pbus, &message, 1);
     if (ret < 0)
     {
         //printf("%s:%d write data error:%s\n", __func__, __LINE__, strerror(errno));
@@ -164,7 +365,7 @@ int i2c_write_reg8a16(unsigned char dev_addr,unsigned short reg_addr,unsigned ch
 /**
  * i2c Write reg
  * */
-int i2c_write_reg8a8(unsigned char dev_addr,unsigned char reg_addr,unsigned char value_byte)
+int i2c_write_reg8a8(pi2c_bus pbus,unsigned char dev_addr,unsigned char reg_addr,unsigned char value_byte)
 {
     int ret = 0;
     unsigned char buf[3]={0};
@@ -173,15 +374,17 @@ int i2c_write_reg8a8(unsigned char dev_addr,unsigned char reg_addr,unsigned char
     buf[0] = reg_addr;//Low reg
     buf[1] = value_byte;//Reg value
 
+    if (pbus->batch_depth > 0)
+        return i2c_batch_queue_write(pbus, dev_addr, buf, 2);
+
     message.addr = dev_addr;//Slave address
     message.buf = buf;
     message.flags = 0;//Write
     message.len = 2;
 
-    i2c_data.msgs = &message;
-    i2c_data.nmsgs = 1;
+    i2c_batch_flush(pbus);
 
-    ret = ioctl(i2c_fd, I2C_RDWR,&i2c_data);
+    ret = i2c_transfer(pbus, &message, 1);
     if (ret < 0)
     {
         //printf("%s:%d write data error:%s\n", __func__, __LINE__, strerror(errno));
@@ -193,20 +396,22 @@ int i2c_write_reg8a8(unsigned char dev_addr,unsigned char reg_addr,unsigned char
 /**
  * i2c Write reg
  * */
-int i2c_write_buffer(unsigned char dev_addr,unsigned char *pbuf,size_t length)
+int i2c_write_buffer(pi2c_bus pbus,unsigned char dev_addr,unsigned char *pbuf,size_t length)
 {
     int ret = 0;
     struct i2c_msg message;
 
+    if ((pbus->batch_depth > 0) && (length <= I2C_BATCH_POOL_SIZE))
+        return i2c_batch_queue_write(pbus, dev_addr, pbuf, length);
+
     message.addr = dev_addr;//Slave address
     message.buf = pbuf;
     message.flags = 0;//Write
     message.len = length;
 
-    i2c_data.msgs = &message;
-    i2c_data.nmsgs = 1;
+    i2c_batch_flush(pbus);
 
-    ret = ioctl(i2c_fd, I2C_RDWR,&i2c_data);
+    ret = i2c_transfer(pbus, &message, 1);
     if (ret < 0)
     {
         //printf("%s:%d write data error:%s\n", __func__, __LINE__, strerror(errno));
@@ -214,3 +419,96 @@ int i2c_write_buffer(unsigned char dev_addr,unsigned char *pbuf,size_t length)
     }
     return 0;
 }
+
+/**
+ * i2c burst write: 2-byte register address followed by length bytes
+ * stored at consecutive addresses
+ * */
+int i2c_write_burst8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,const unsigned char *buf,size_t length)
+{
+    unsigned char buf_out[I2C_BURST_MAX + 2];
+
+    if (length > I2C_BURST_MAX)
+        return -1;
+
+    buf_out[0] = (reg_addr >> 8) & 0xFF;//High reg
+    buf_out[1] = reg_addr & 0xFF;//Low reg
+    memcpy(&buf_out[2], buf, length);
+
+    return i2c_write_buffer(pbus, dev_addr, buf_out, length + 2);
+}
+
+/**
+ * Start collecting writes into the transaction queue. Calls may nest,
+ * the queue is flushed by the outermost i2c_batch_end().
+ * */
+int i2c_batch_begin(pi2c_bus pbus)
+{
+    if (pbus->batch_depth++ == 0)
+    {
+        pbus->batch_nmsgs = 0;
+        pbus->batch_pool_used = 0;
+        pbus->batch_error = 0;
+    }
+    return 0;
+}
+
+/**
+ * Stop collecting, flush the queue and report any error seen since begin
+ * */
+int i2c_batch_end(pi2c_bus pbus)
+{
+    int ret = 0;
+
+    if (pbus->batch_depth == 0)
+        return 0;
+
+    if (--pbus->batch_depth > 0)
+        return 0;
+
+    i2c_batch_flush(pbus);
+
+    ret = pbus->batch_error;
+    pbus->batch_error = 0;
+
+    return ret;
+}
+
+/**
+ * Queue a register read, buf is filled on the next flush
+ * */
+int i2c_batch_read_reg8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,unsigned char *buf)
+{
+    return i2c_batch_read_burst8a16(pbus, dev_addr, reg_addr, buf, 1);
+}
+
+/**
+ * Queue a burst read, buf is filled on the next flush
+ * */
+int i2c_batch_read_burst8a16(pi2c_bus pbus,unsigned char dev_addr,unsigned short reg_addr,unsigned char *buf,size_t length)
+{
+    unsigned char *preg;
+    struct i2c_msg *message;
+
+    if (pbus->batch_depth == 0)
+        return i2c_read_burst8a16(pbus, dev_addr, reg_addr, buf, length);
+
+    preg = i2c_batch_reserve(pbus, 2, 2);
+
+    preg[0] = (reg_addr >> 8) & 0xFF;
+    preg[1] = reg_addr & 0xFF;
+
+    message = &pbus->batch_msgs[pbus->batch_nmsgs++];
+    message->addr = dev_addr;//Slave address
+    message->flags = 0;   //Write
+    message->buf = preg;//Register 2 bytes
+    message->len = 2;
+
+    message = &pbus->batch_msgs[pbus->batch_nmsgs++];
+    message->addr = dev_addr;//Slave address
+    message->flags = I2C_M_RD; //Read
+    message->buf = buf;
+    message->len = length; // length bytes of data
+
+    return 0;
+}
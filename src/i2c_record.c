@@ -0,0 +1,380 @@
+/**
+ * @file   i2c_record.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  I2C traffic recording and replay transport.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <linux/i2c.h>
+#include "serdes_head.h"
+
+/*
+ * Log layout, host byte order:
+ *   "GMSLREC1"
+ *   per transfer: i2c_rec_xfer, then per message i2c_rec_msg and its data
+ *   (written bytes, or the bytes read back)
+ */
+#define I2C_REC_MAGIC       "GMSLREC1"
+
+typedef struct i2c_rec_xfer_ {
+    uint64_t    ts_ns;      /* From the start of the recording */
+    uint32_t    dur_ns;
+    int32_t     result;     /* 0 or -errno */
+    uint16_t    nmsgs;
+    uint16_t    reserved;
+} i2c_rec_xfer;
+
+typedef struct i2c_rec_msg_ {
+    uint16_t    addr;
+    uint16_t    flags;
+    uint16_t    len;
+    uint16_t    reserved;
+} i2c_rec_msg;
+
+/* One byte read back from the device */
+typedef struct i2c_replay_entry_ {
+    uint64_t    ts_ns;
+    uint16_t    reg_addr;
+    uint8_t     dev_addr;
+    uint8_t     value;
+    int32_t     result;
+} i2c_replay_entry;
+
+typedef struct i2c_replay_state_ {
+    i2c_replay_entry    *entries;
+    size_t              num_entries;
+    uint8_t             present[128];   /* Devices seen in the log */
+    uint64_t            now_ns;
+    uint64_t            byte_ns;        /* Bus time per byte, from the log */
+} i2c_replay_state;
+
+static const i2c_transport *rec_inner;
+static i2c_transport rec_tp;
+static FILE *rec_fp;
+static uint64_t rec_start_ns;
+
+static i2c_replay_state replay;
+
+static int i2c_record_open(pi2c_bus pbus)
+{
+    int ret = rec_inner->open(pbus);
+
+    rec_start_ns = time_monotonic_ns(pbus);
+
+    return ret;
+}
+
+static int i2c_record_close(pi2c_bus pbus)
+{
+    if (rec_fp != NULL)
+    {
+        fclose(rec_fp);
+        rec_fp = NULL;
+    }
+
+    return rec_inner->close(pbus);
+}
+
+static int i2c_record_transfer(pi2c_bus pbus, struct i2c_msg *msgs, int nmsgs)
+{
+    i2c_rec_xfer xfer;
+    i2c_rec_msg msg;
+    uint64_t start_ns;
+    int ret, err, i;
+
+    start_ns = time_monotonic_ns(pbus);
+    ret = rec_inner->transfer(pbus, msgs, nmsgs);
+    err = (ret < 0) ? errno : 0;
+
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.ts_ns = start_ns - rec_start_ns;
+    xfer.dur_ns = time_monotonic_ns(pbus) - start_ns;
+    xfer.result = -err;
+    xfer.nmsgs = nmsgs;
+    fwrite(&xfer, sizeof(xfer), 1, rec_fp);
+
+    for (i = 0; i < nmsgs; i++)
+    {
+        memset(&msg, 0, sizeof(msg));
+        msg.addr = msgs[i].addr;
+        msg.flags = msgs[i].flags;
+        msg.len = msgs[i].len;
+        fwrite(&msg, sizeof(msg), 1, rec_fp);
+        fwrite(msgs[i].buf, 1, msgs[i].len, rec_fp);
+    }
+
+    errno = err;
+
+    return ret;
+}
+
+/**
+ * Log every transfer of the current transport to a file
+ * */
+int i2c_record_start(const char *path)
+{
+    rec_fp = fopen(path, "wb");
+    if (rec_fp == NULL)
+    {
+        printf("Error: can't create %s: %s\r\n", path, strerror(errno));
+        return -errno;
+    }
+
+    fwrite(I2C_REC_MAGIC, 1, strlen(I2C_REC_MAGIC), rec_fp);
+
+    rec_inner = i2c_get_transport();
+    rec_tp = *rec_inner;
+    rec_tp.name = "record";
+    rec_tp.open = i2c_record_open;
+    rec_tp.close = i2c_record_close;
+    rec_tp.transfer = i2c_record_transfer;
+    i2c_set_transport(&rec_tp);
+
+    return 0;
+}
+
+static int i2c_replay_cmp(const void *a, const void *b)
+{
+    const i2c_replay_entry *pa = a, *pb = b;
+
+    if (pa->dev_addr != pb->dev_addr)
+        return pa->dev_addr - pb->dev_addr;
+    if (pa->reg_addr != pb->reg_addr)
+        return pa->reg_addr - pb->reg_addr;
+    if (pa->ts_ns != pb->ts_ns)
+        return (pa->ts_ns < pb->ts_ns) ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Byte the device returned for the register at the given time: the
+ * latest recorded read at or before it, the first one if none
+ * */
+static const i2c_replay_entry *i2c_replay_lookup(uint8_t dev_addr, uint16_t reg_addr)
+{
+    size_t lo = 0, hi = replay.num_entries, mid;
+    const i2c_replay_entry *pfound = NULL, *pentry;
+
+    /* First entry of the register */
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        pentry = &replay.entries[mid];
+        if ((pentry->dev_addr < dev_addr) ||
+            ((pentry->dev_addr == dev_addr) && (pentry->reg_addr < reg_addr)))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (; lo < replay.num_entries; lo++)
+    {
+        pentry = &replay.entries[lo];
+        if ((pentry->dev_addr != dev_addr) || (pentry->reg_addr != reg_addr))
+            break;
+        if ((pfound != NULL) && (pentry->ts_ns > replay.now_ns))
+            break;
+        pfound = pentry;
+    }
+
+    return pfound;
+}
+
+static int i2c_replay_open(pi2c_bus pbus)
+{
+    printf("Replaying bus %d: %zu recorded register reads\r\n", pbus->bus_num, replay.num_entries);
+
+    return 0;
+}
+
+static int i2c_replay_close(pi2c_bus pbus)
+{
+    (void)pbus;
+
+    free(replay.entries);
+    replay.entries = NULL;
+    replay.num_entries = 0;
+
+    return 0;
+}
+
+static int i2c_replay_transfer(pi2c_bus pbus, struct i2c_msg *msgs, int nmsgs)
+{
+    const i2c_replay_entry *pentry;
+    uint16_t reg_addr = 0;
+    int i, k;
+
+    (void)pbus;
+
+    for (i = 0; i < nmsgs; i++)
+    {
+        replay.now_ns += (uint64_t)(msgs[i].len + 1) * replay.byte_ns;
+
+        if (replay.present[msgs[i].addr & 0x7F] == 0)
+        {
+            errno = ENXIO;
+            return -1;
+        }
+
+        if (!(msgs[i].flags & I2C_M_RD))
+        {
+            /* Writes only move the register pointer */
+            if (msgs[i].len >= 2)
+                reg_addr = (msgs[i].buf[0] << 8) | msgs[i].buf[1];
+            continue;
+        }
+
+        for (k = 0; k < msgs[i].len; k++)
+        {
+            pentry = i2c_replay_lookup(msgs[i].addr, reg_addr + k);
+            if ((pentry != NULL) && (pentry->result < 0))
+            {
+                errno = -pentry->result;
+                return -1;
+            }
+            msgs[i].buf[k] = (pentry != NULL) ? pentry->value : 0;
+        }
+        reg_addr += msgs[i].len;
+    }
+
+    return 0;
+}
+
+static uint64_t i2c_replay_now_ns(pi2c_bus pbus)
+{
+    (void)pbus;
+    return replay.now_ns;
+}
+
+static void i2c_replay_sleep_until_ns(pi2c_bus pbus, uint64_t wake_ns)
+{
+    (void)pbus;
+
+    if (wake_ns > replay.now_ns)
+        replay.now_ns = wake_ns;
+}
+
+static const i2c_transport replay_tp = {
+    .name           = "replay",
+    .open           = i2c_replay_open,
+    .close          = i2c_replay_close,
+    .transfer       = i2c_replay_transfer,
+    .now_ns         = i2c_replay_now_ns,
+    .sleep_until_ns = i2c_replay_sleep_until_ns,
+    .priv           = &replay,
+};
+
+static int i2c_replay_add(const i2c_replay_entry *pentry, size_t *capacity)
+{
+    i2c_replay_entry *pnew;
+
+    if (replay.num_entries == *capacity)
+    {
+        *capacity = (*capacity != 0) ? *capacity * 2 : 1024;
+        pnew = realloc(replay.entries, *capacity * sizeof(i2c_replay_entry));
+        if (pnew == NULL)
+            return -ENOMEM;
+        replay.entries = pnew;
+    }
+
+    replay.entries[replay.num_entries++] = *pentry;
+
+    return 0;
+}
+
+/**
+ * Serve reads from a recorded log. Read responses are looked up per
+ * device register by time, bus time per byte is taken from the log.
+ * */
+int i2c_replay_setup(const char *path)
+{
+    char magic[8];
+    uint8_t data[0x10000];
+    i2c_rec_xfer xfer;
+    i2c_rec_msg msg;
+    i2c_replay_entry entry;
+    uint64_t total_ns = 0, total_bytes = 0;
+    uint16_t reg_addr = 0;
+    size_t capacity = 0;
+    FILE *fp;
+    int i, k, ret = 0;
+
+    fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        printf("Error: can't open %s: %s\r\n", path, strerror(errno));
+        return -errno;
+    }
+
+    if ((fread(magic, 1, sizeof(magic), fp) != sizeof(magic)) ||
+        (memcmp(magic, I2C_REC_MAGIC, sizeof(magic)) != 0))
+    {
+        printf("Error: %s is not an I2C recording\r\n", path);
+        fclose(fp);
+        return -EINVAL;
+    }
+
+    memset(&replay, 0, sizeof(replay));
+
+    while ((ret == 0) && (fread(&xfer, sizeof(xfer), 1, fp) == 1))
+    {
+        total_ns += xfer.dur_ns;
+
+        for (i = 0; i < xfer.nmsgs; i++)
+        {
+            if ((fread(&msg, sizeof(msg), 1, fp) != 1) ||
+                (fread(data, 1, msg.len, fp) != msg.len))
+            {
+                ret = -EINVAL;
+                break;
+            }
+
+            total_bytes += msg.len + 1;
+
+            if (xfer.result == 0)
+                replay.present[msg.addr & 0x7F] = 1;
+
+            if (!(msg.flags & I2C_M_RD))
+            {
+                if (msg.len >= 2)
+                    reg_addr = (data[0] << 8) | data[1];
+                continue;
+            }
+
+            for (k = 0; (k < msg.len) && (ret == 0); k++)
+            {
+                entry.ts_ns = xfer.ts_ns;
+                entry.dev_addr = msg.addr;
+                entry.reg_addr = reg_addr + k;
+                entry.value = data[k];
+                entry.result = xfer.result;
+                ret = i2c_replay_add(&entry, &capacity);
+            }
+            reg_addr += msg.len;
+        }
+    }
+
+    fclose(fp);
+
+    if (ret < 0)
+    {
+        printf("Error: %s is truncated\r\n", path);
+        free(replay.entries);
+        replay.entries = NULL;
+        return ret;
+    }
+
+    qsort(replay.entries, replay.num_entries, sizeof(i2c_replay_entry), i2c_replay_cmp);
+
+    replay.byte_ns = (total_bytes != 0) ? total_ns / total_bytes : 0;
+
+    i2c_set_transport(&replay_tp);
+
+    return 0;
+}
@@ -0,0 +1,624 @@
+/**
+ * @file   i2c_sim.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  Simulated I2C transport with SerDes register files.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <errno.h>
+#include <linux/i2c.h>
+#include "serdes_head.h"
+
+#define SIM_LOCK_TIME_MS        (15)
+#define SIM_XFER_OVERHEAD_US    (40)
+/* GMSL control channel forwarding, per message to the serializer */
+#define SIM_REMOTE_OVERHEAD_US  (25)
+/* 9 bit times at 400kHz */
+#define SIM_BYTE_NS             (22500)
+#define SIM_MAX_LINKS           (4)
+
+/*
+ * Counter registers. count 0 - read-to-clear error counters that stay 0,
+ * else free-running packet counters of count bits (two 4-bit ones share a
+ * register) growing by one per ms while the link is up
+ */
+typedef struct sim_range_ {
+    uint16_t    first;
+    uint16_t    last;
+    uint8_t     count;
+} sim_range;
+
+/* Status bits which always read as set */
+typedef struct sim_bits_ {
+    uint16_t    addr;
+    uint8_t     bits;
+} sim_bits;
+
+typedef struct sim_chip_ {
+    const char      *name;
+    uint8_t         devid;
+    uint8_t         i2c_addr;
+    uint8_t         deser;
+    int             links;          /* GMSL links, 1 if not set */
+    uint16_t        rate_reg;       /* 2-bit field: 1 - 3G, 2 - 6G, 3 - 12G */
+    uint8_t         rate_shift;
+    uint8_t         rate_default;
+    uint16_t        ctrl_reg;
+    uint8_t         oneshot_mask;   /* Self-clearing, retrains the link */
+    uint8_t         hold_mask;      /* Link kept in reset while set */
+    uint16_t        lock_reg;       /* LOCKED at bit 3 */
+    const uint16_t  *link_lock_regs;    /* Per link, multi-link chips */
+    uint16_t        cc_reg;         /* DIS_REM_CC_x at bit 2x, 0 - none */
+    const sim_bits  *status;
+    int             num_status;
+    const sim_range *counters;
+    int             num_counters;
+} sim_chip;
+
+#define SIM_MAX_COUNTERS        (4)
+
+typedef struct sim_dev_ {
+    const sim_chip  *chip;
+    int             link;           /* Link the serializer sits on, -1 - deserializer */
+    uint8_t         i2c_addr;       /* Serializers can be moved through REG0 */
+    uint8_t         active_rate[SIM_MAX_LINKS];
+    uint16_t        reg_ptr;
+    uint64_t        count_mark_ns[SIM_MAX_COUNTERS];
+    uint8_t         regs[REGCACHE_SIZE];
+} sim_dev;
+
+typedef struct sim_state_ {
+    sim_dev         deser;
+    sim_dev         ser[SIM_MAX_LINKS]; /* No chip - nothing on the link */
+    uint64_t        now_ns;
+    uint64_t        lock_at_ns[SIM_MAX_LINKS];
+    uint64_t        lock_ns;
+    uint64_t        overhead_ns;
+    uint64_t        remote_ns;
+} sim_state;
+
+/* CTRL3, CTRL12, CTRL13, CTRL14 */
+static const uint16_t max96724_lock_regs[] = { 0x001A, 0x000A, 0x000B, 0x000C };
+
+static const sim_bits max96714_status[] = {
+    { 0x0308, 0x20 },   /* CSIPLLY_LOCK */
+};
+
+static const sim_bits max96792_status[] = {
+    { 0x0308, 0x60 },   /* CSIPLLY_LOCK, CSIPLLZ_LOCK */
+};
+
+static const sim_bits max96724_status[] = {
+    { 0x0400, 0xF0 },   /* CSIPLLx_LOCK */
+};
+
+static const sim_bits max96717_status[] = {
+    { 0x0112, 0x80 },   /* PCLKDET */
+};
+
+static const sim_bits max9295d_status[] = {
+    { 0x0102, 0x80 },
+    { 0x010A, 0x80 },
+    { 0x0112, 0x80 },
+    { 0x011A, 0x80 },
+};
+
+static const sim_range max96714_counters[] = {
+    { 0x0022, 0x0027, 0 },
+};
+
+static const sim_range max96724_counters[] = {
+    { 0x0022, 0x002A, 0 },
+    { 0x0040, 0x0043, 8 },
+    { 0x08D0, 0x08D3, 4 },
+};
+
+static const sim_range max96717_counters[] = {
+    { 0x0022, 0x0027, 0 },
+    { 0x038D, 0x0390, 8 },
+};
+
+static const sim_chip sim_chips[] = {
+  {
+    .name = "max96714", .devid = 0xC9, .i2c_addr = 0x28, .deser = 1,
+    .rate_reg = 0x0001, .rate_shift = 0, .rate_default = 2,
+    .ctrl_reg = 0x0010, .oneshot_mask = 0x20, .hold_mask = 0x40, .lock_reg = 0x0013,
+    .status = max96714_status, .num_status = ARRAY_SIZE(max96714_status),
+    .counters = max96714_counters, .num_counters = ARRAY_SIZE(max96714_counters),
+  },
+  {
+    .name = "max96792", .devid = 0xB6, .i2c_addr = 0x28, .deser = 1,
+    .rate_reg = 0x0001, .rate_shift = 0, .rate_default = 3,
+    .ctrl_reg = 0x0010, .oneshot_mask = 0x20, .hold_mask = 0x40, .lock_reg = 0x0013,
+    .status = max96792_status, .num_status = ARRAY_SIZE(max96792_status),
+    .counters = max96714_counters, .num_counters = ARRAY_SIZE(max96714_counters),
+  },
+  {
+    .name = "max96712", .devid = 0xA0, .i2c_addr = 0x27, .deser = 1, .links = 4,
+    .rate_reg = 0x0010, .rate_shift = 0, .rate_default = 2,
+    .ctrl_reg = 0x0018, .oneshot_mask = 0x0F, .hold_mask = 0xF0, .lock_reg = 0x001A,
+    .link_lock_regs = max96724_lock_regs, .cc_reg = 0x0003,
+    .status = max96724_status, .num_status = ARRAY_SIZE(max96724_status),
+    .counters = max96724_counters, .num_counters = ARRAY_SIZE(max96724_counters),
+  },
+  {
+    .name = "max96724", .devid = 0xA2, .i2c_addr = 0x27, .deser = 1, .links = 4,
+    .rate_reg = 0x0010, .rate_shift = 0, .rate_default = 2,
+    .ctrl_reg = 0x0018, .oneshot_mask = 0x0F, .hold_mask = 0xF0, .lock_reg = 0x001A,
+    .link_lock_regs = max96724_lock_regs, .cc_reg = 0x0003,
+    .status = max96724_status, .num_status = ARRAY_SIZE(max96724_status),
+    .counters = max96724_counters, .num_counters = ARRAY_SIZE(max96724_counters),
+  },
+  {
+    .name = "max96717", .devid = 0xBF, .i2c_addr = 0x40, .deser = 0,
+    .rate_reg = 0x0001, .rate_shift = 2, .rate_default = 2,
+    .ctrl_reg = 0x0010, .oneshot_mask = 0x20, .hold_mask = 0x40, .lock_reg = 0x0013,
+    .status = max96717_status, .num_status = ARRAY_SIZE(max96717_status),
+    .counters = max96717_counters, .num_counters = ARRAY_SIZE(max96717_counters),
+  },
+  {
+    .name = "max96793", .devid = 0xB7, .i2c_addr = 0x40, .deser = 0,
+    .rate_reg = 0x0001, .rate_shift = 2, .rate_default = 3,
+    .ctrl_reg = 0x0010, .oneshot_mask = 0x20, .hold_mask = 0x40, .lock_reg = 0x0013,
+    .status = max96717_status, .num_status = ARRAY_SIZE(max96717_status),
+    .counters = max96717_counters, .num_counters = ARRAY_SIZE(max96717_counters),
+  },
+  {
+    .name = "max9295d", .devid = 0x95, .i2c_addr = 0x40, .deser = 0,
+    .rate_reg = 0x0001, .rate_shift = 2, .rate_default = 2,
+    .ctrl_reg = 0x0010, .oneshot_mask = 0x20, .hold_mask = 0x40, .lock_reg = 0x0013,
+    .status = max9295d_status, .num_status = ARRAY_SIZE(max9295d_status),
+    .counters = max96714_counters, .num_counters = ARRAY_SIZE(max96714_counters),
+  },
+};
+
+/* Chips picked by i2c_sim_setup(), each opened bus gets its own copy */
+static sim_state sim_template;
+
+/* Rate field, one-shot and hold bits of one link of a chip */
+typedef struct sim_link_bits_ {
+    uint16_t    rate_reg;
+    uint8_t     rate_shift;
+    uint8_t     oneshot;
+    uint8_t     hold;
+} sim_link_bits;
+
+static int sim_num_links(const sim_chip *pchip)
+{
+    return (pchip->links > 1) ? pchip->links : 1;
+}
+
+/**
+ * Multi-link chips pack the rate fields of two links per register and
+ * have one one-shot and one hold bit per link
+ * */
+static sim_link_bits sim_get_link_bits(const sim_chip *pchip, int link)
+{
+    sim_link_bits bits;
+
+    if (sim_num_links(pchip) == 1)
+    {
+        bits.rate_reg = pchip->rate_reg;
+        bits.rate_shift = pchip->rate_shift;
+        bits.oneshot = pchip->oneshot_mask;
+        bits.hold = pchip->hold_mask;
+        return bits;
+    }
+
+    bits.rate_reg = pchip->rate_reg + link / 2;
+    bits.rate_shift = pchip->rate_shift + (link % 2) * 4;
+    bits.oneshot = pchip->oneshot_mask & (0x01 << link);
+    bits.hold = pchip->hold_mask & (0x10 << link);
+
+    return bits;
+}
+
+/* Link whose LOCKED bit the register holds, -1 - not a lock register */
+static int sim_lock_link(const sim_chip *pchip, uint16_t reg_addr)
+{
+    int i;
+
+    if (pchip->link_lock_regs == NULL)
+        return (reg_addr == pchip->lock_reg) ? 0 : -1;
+
+    for (i = 0; i < sim_num_links(pchip); i++)
+    {
+        if (pchip->link_lock_regs[i] == reg_addr)
+            return i;
+    }
+
+    return -1;
+}
+
+static uint8_t sim_rate_field(sim_dev *pdev, int link)
+{
+    sim_link_bits bits = sim_get_link_bits(pdev->chip, link);
+
+    return (pdev->regs[bits.rate_reg] >> bits.rate_shift) & 0x3;
+}
+
+static int sim_link_up(sim_state *psim, int link)
+{
+    sim_dev *pser = &psim->ser[link];
+
+    if (pser->chip == NULL)
+        return 0;
+
+    return ((psim->deser.regs[psim->deser.chip->ctrl_reg] &
+                sim_get_link_bits(psim->deser.chip, link).hold) == 0) &&
+           ((pser->regs[pser->chip->ctrl_reg] & pser->chip->hold_mask) == 0) &&
+           (psim->deser.active_rate[link] == pser->active_rate[0]) &&
+           (psim->now_ns >= psim->lock_at_ns[link]);
+}
+
+/* Serializer: its own link, deserializer: any of its links */
+static int sim_dev_link_up(sim_state *psim, sim_dev *pdev)
+{
+    int i;
+
+    if (pdev->link >= 0)
+        return sim_link_up(psim, pdev->link);
+
+    for (i = 0; i < sim_num_links(pdev->chip); i++)
+    {
+        if (sim_link_up(psim, i))
+            return 1;
+    }
+
+    return 0;
+}
+
+static void sim_retrain(sim_state *psim, int link)
+{
+    psim->lock_at_ns[link] = psim->now_ns + psim->lock_ns;
+}
+
+static void sim_reset(sim_dev *pdev, const sim_chip *pchip, int link)
+{
+    sim_link_bits bits;
+    int i;
+
+    memset(pdev, 0, sizeof(*pdev));
+
+    pdev->chip = pchip;
+    pdev->link = link;
+    pdev->i2c_addr = pchip->i2c_addr;
+    pdev->regs[0x0000] = pchip->i2c_addr << 1;
+    pdev->regs[0x000D] = pchip->devid;
+
+    for (i = 0; i < sim_num_links(pchip); i++)
+    {
+        bits = sim_get_link_bits(pchip, i);
+        pdev->regs[bits.rate_reg] |= pchip->rate_default << bits.rate_shift;
+        pdev->active_rate[i] = pchip->rate_default;
+    }
+}
+
+static void sim_write(sim_state *psim, sim_dev *pdev, uint16_t reg_addr, uint8_t value)
+{
+    const sim_chip *pchip = pdev->chip;
+    uint8_t ctrl = pdev->regs[pchip->ctrl_reg];
+    sim_link_bits bits;
+    int i, link;
+
+    /* Read-only */
+    if ((reg_addr == 0x000D) || (sim_lock_link(pchip, reg_addr) >= 0))
+        return;
+
+    if (reg_addr == pchip->ctrl_reg)
+        pdev->regs[reg_addr] = value & ~pchip->oneshot_mask;
+    else
+        pdev->regs[reg_addr] = value;
+
+    /* DEV_ADDR */
+    if ((reg_addr == 0x0000) && (pdev->link >= 0))
+        pdev->i2c_addr = value >> 1;
+
+    for (i = 0; i < sim_num_links(pchip); i++)
+    {
+        bits = sim_get_link_bits(pchip, i);
+        link = (pdev->link >= 0) ? pdev->link : i;
+
+        if (reg_addr == pchip->ctrl_reg)
+        {
+            if ((value & bits.oneshot) ||
+                ((ctrl & bits.hold) && ((value & bits.hold) == 0)))
+            {
+                pdev->active_rate[i] = sim_rate_field(pdev, i);
+                sim_retrain(psim, link);
+            }
+            continue;
+        }
+
+        /* A new rate takes effect at once unless the link is held */
+        if ((reg_addr == bits.rate_reg) && ((ctrl & bits.hold) == 0) &&
+            (sim_rate_field(pdev, i) != pdev->active_rate[i]))
+        {
+            pdev->active_rate[i] = sim_rate_field(pdev, i);
+            sim_retrain(psim, link);
+        }
+    }
+}
+
+static uint8_t sim_read(sim_state *psim, sim_dev *pdev, uint16_t reg_addr)
+{
+    const sim_chip *pchip = pdev->chip;
+    uint64_t grow;
+    uint8_t value;
+    int i, r, link;
+
+    link = sim_lock_link(pchip, reg_addr);
+    if (link >= 0)
+    {
+        if (pdev->link >= 0)
+            link = pdev->link;
+        return (pdev->regs[reg_addr] & ~0x08) | (sim_link_up(psim, link) ? 0x08 : 0);
+    }
+
+    for (i = 0; i < pchip->num_status; i++)
+    {
+        if (pchip->status[i].addr == reg_addr)
+            return pdev->regs[reg_addr] | pchip->status[i].bits;
+    }
+
+    for (i = 0; (i < pchip->num_counters) && (i < SIM_MAX_COUNTERS); i++)
+    {
+        if ((reg_addr < pchip->counters[i].first) || (reg_addr > pchip->counters[i].last))
+            continue;
+
+        if (pchip->counters[i].count == 0)
+        {
+            value = pdev->regs[reg_addr];
+            pdev->regs[reg_addr] = 0;
+            return value;
+        }
+
+        /* Packets since the previous read of the range, whole ms only */
+        if (sim_dev_link_up(psim, pdev))
+        {
+            grow = (psim->now_ns - pdev->count_mark_ns[i]) / 1000000ULL;
+            for (r = pchip->counters[i].first; (grow != 0) && (r <= pchip->counters[i].last); r++)
+            {
+                if (pchip->counters[i].count == 4)
+                    pdev->regs[r] = (((pdev->regs[r] >> 4) + grow) & 0x0F) << 4 |
+                                    ((pdev->regs[r] + grow) & 0x0F);
+                else
+                    pdev->regs[r] += grow;
+            }
+            pdev->count_mark_ns[i] += grow * 1000000ULL;
+        } else {
+            pdev->count_mark_ns[i] = psim->now_ns;
+        }
+
+        return pdev->regs[reg_addr];
+    }
+
+    return pdev->regs[reg_addr];
+}
+
+/**
+ * Devices answering an address. Serializers are reached over links that
+ * are up and whose remote control channel is enabled; several of them at
+ * one address all take the message.
+ * */
+static int sim_find_devs(sim_state *psim, uint16_t addr, sim_dev **pdevs)
+{
+    const sim_chip *pdeser = psim->deser.chip;
+    int i, num = 0;
+
+    if (addr == pdeser->i2c_addr)
+    {
+        pdevs[0] = &psim->deser;
+        return 1;
+    }
+
+    for (i = 0; i < sim_num_links(pdeser); i++)
+    {
+        if ((psim->ser[i].chip == NULL) || (psim->ser[i].i2c_addr != addr))
+            continue;
+
+        if ((pdeser->cc_reg != 0) && (psim->deser.regs[pdeser->cc_reg] & (1 << (2 * i))))
+            continue;
+
+        if (sim_link_up(psim, i))
+            pdevs[num++] = &psim->ser[i];
+    }
+
+    return num;
+}
+
+static int sim_open(pi2c_bus pbus)
+{
+    sim_state *psim;
+    int i;
+
+    psim = malloc(sizeof(sim_state));
+    if (psim == NULL)
+        return -ENOMEM;
+
+    *psim = sim_template;
+    pbus->tp_priv = psim;
+
+    printf("Simulated bus %d: %s at 0x%02X", pbus->bus_num,
+            psim->deser.chip->name, psim->deser.chip->i2c_addr);
+
+    for (i = 0; i < sim_num_links(psim->deser.chip); i++)
+    {
+        if (psim->ser[i].chip == NULL)
+            continue;
+
+        printf(", %s at 0x%02X", psim->ser[i].chip->name, psim->ser[i].chip->i2c_addr);
+        if (sim_num_links(psim->deser.chip) > 1)
+            printf(" on link %c", 'A' + i);
+    }
+
+    printf("\r\n");
+
+    return 0;
+}
+
+static int sim_close(pi2c_bus pbus)
+{
+    free(pbus->tp_priv);
+    pbus->tp_priv = NULL;
+    return 0;
+}
+
+static int sim_transfer(pi2c_bus pbus, struct i2c_msg *msgs, int nmsgs)
+{
+    sim_state *psim = (sim_state *)pbus->tp_priv;
+    sim_dev *pdevs[SIM_MAX_LINKS];
+    uint8_t value;
+    int i, k, d, num;
+
+    psim->now_ns += psim->overhead_ns;
+
+    for (i = 0; i < nmsgs; i++)
+    {
+        /* Address byte and data */
+        psim->now_ns += (uint64_t)(msgs[i].len + 1) * SIM_BYTE_NS;
+
+        num = sim_find_devs(psim, msgs[i].addr, pdevs);
+        if (num == 0)
+        {
+            errno = ENXIO;
+            return -1;
+        }
+
+        if (pdevs[0] != &psim->deser)
+            psim->now_ns += psim->remote_ns;
+
+        if (msgs[i].flags & I2C_M_RD)
+        {
+            /* Open drain: devices answering together AND their bits */
+            for (k = 0; k < msgs[i].len; k++)
+            {
+                value = 0xFF;
+                for (d = 0; d < num; d++)
+                    value &= sim_read(psim, pdevs[d], pdevs[d]->reg_ptr++);
+                msgs[i].buf[k] = value;
+            }
+        } else if (msgs[i].len >= 2) {
+            for (d = 0; d < num; d++)
+            {
+                pdevs[d]->reg_ptr = (msgs[i].buf[0] << 8) | msgs[i].buf[1];
+                for (k = 2; k < msgs[i].len; k++)
+                    sim_write(psim, pdevs[d], pdevs[d]->reg_ptr++, msgs[i].buf[k]);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static uint64_t sim_now_ns(pi2c_bus pbus)
+{
+    sim_state *psim = (sim_state *)pbus->tp_priv;
+
+    return psim->now_ns;
+}
+
+static void sim_sleep_until_ns(pi2c_bus pbus, uint64_t wake_ns)
+{
+    sim_state *psim = (sim_state *)pbus->tp_priv;
+
+    if (wake_ns > psim->now_ns)
+        psim->now_ns = wake_ns;
+}
+
+static const i2c_transport sim_transport = {
+    .name           = "sim",
+    .open           = sim_open,
+    .close          = sim_close,
+    .transfer       = sim_transfer,
+    .now_ns         = sim_now_ns,
+    .sleep_until_ns = sim_sleep_until_ns,
+    .priv           = &sim_template,
+};
+
+static const sim_chip *sim_find_chip(const char *name, int deser)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(sim_chips); i++)
+    {
+        if ((strcasecmp(sim_chips[i].name, name) == 0) && (sim_chips[i].deser == deser))
+            return &sim_chips[i];
+    }
+
+    printf("Error: unknown simulated %s %s\r\n", deser ? "deserializer" : "serializer", name);
+
+    return NULL;
+}
+
+/**
+ * Route the bus to the simulator.
+ * spec: <deserializer>:<serializer>[:<lock ms>[:<overhead us>[:<remote us>]]]
+ * Multi-link deserializers take a serializer per link joined with '+',
+ * '-' for a link with nothing on it: max96724:max96717+-+max96717
+ * */
+int i2c_sim_setup(const char *spec)
+{
+    char buf[128], *deser_name, *ser_names, *lock_ms, *overhead_us, *remote_us, *ser_name, *psave;
+    const sim_chip *pdeser, *pser;
+    int link = 0, i;
+
+    snprintf(buf, sizeof(buf), "%s", spec);
+
+    deser_name = strtok(buf, ":");
+    ser_names = strtok(NULL, ":");
+    lock_ms = strtok(NULL, ":");
+    overhead_us = strtok(NULL, ":");
+    remote_us = strtok(NULL, ":");
+
+    if ((deser_name == NULL) || (ser_names == NULL))
+    {
+        printf("Error: simulator needs <deserializer>:<serializer>\r\n");
+        return -EINVAL;
+    }
+
+    pdeser = sim_find_chip(deser_name, 1);
+    if (pdeser == NULL)
+        return -EINVAL;
+
+    memset(&sim_template, 0, sizeof(sim_template));
+    sim_reset(&sim_template.deser, pdeser, -1);
+
+    for (ser_name = strtok_r(ser_names, "+", &psave); ser_name != NULL;
+         ser_name = strtok_r(NULL, "+", &psave), link++)
+    {
+        if (link == sim_num_links(pdeser))
+        {
+            printf("Error: %s has %d links\r\n", pdeser->name, sim_num_links(pdeser));
+            return -EINVAL;
+        }
+
+        if (strcmp(ser_name, "-") == 0)
+            continue;
+
+        pser = sim_find_chip(ser_name, 0);
+        if (pser == NULL)
+            return -EINVAL;
+
+        sim_reset(&sim_template.ser[link], pser, link);
+    }
+
+    sim_template.now_ns = 0;
+    sim_template.lock_ns = ((lock_ms != NULL) ? atol(lock_ms) : SIM_LOCK_TIME_MS) * 1000000ULL;
+    sim_template.overhead_ns = ((overhead_us != NULL) ? atol(overhead_us) : SIM_XFER_OVERHEAD_US) * 1000ULL;
+    sim_template.remote_ns = ((remote_us != NULL) ? atol(remote_us) : SIM_REMOTE_OVERHEAD_US) * 1000ULL;
+
+    /* Links train after power-up */
+    for (i = 0; i < SIM_MAX_LINKS; i++)
+        sim_retrain(&sim_template, i);
+
+    i2c_set_transport(&sim_transport);
+
+    return 0;
+}
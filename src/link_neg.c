@@ -0,0 +1,239 @@
+/**
+ * @file   link_neg.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  Link speed negotiation and last-good rate state file.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+#include "serdes_head.h"
+
+#define LINK_STATE_MAX_ENTRIES  (64)
+
+/* Chains brought up in parallel share the file */
+static pthread_mutex_t link_state_lock = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct link_state_entry_ {
+    int         bus;
+    uint8_t     deser_addr;
+    uint8_t     ser_devid;
+    int         speed;
+} link_state_entry;
+
+static const struct {
+    uint32_t    feature;
+    int         speed;
+} link_neg_rates[] = {
+    { FEATURE_DES_12GBPS, 12 },
+    { FEATURE_DES_6GBPS,   6 },
+    { FEATURE_DES_3GBPS,   3 },
+};
+
+static int link_neg_supported(uint32_t features, int speed)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(link_neg_rates); i++)
+    {
+        if (link_neg_rates[i].speed == speed)
+            return (features & link_neg_rates[i].feature) ? 1 : 0;
+    }
+
+    return 0;
+}
+
+/**
+ * Rates to try in order: the preferred ones first, then the rest from
+ * the fastest one, each rate once. Returns the number of rates.
+ * */
+int link_neg_order(uint32_t features, const int *preferred, int num_preferred, int *speeds)
+{
+    int num_speeds = 0, speed, i, k;
+
+    for (i = 0; i < num_preferred + (int)ARRAY_SIZE(link_neg_rates); i++)
+    {
+        speed = (i < num_preferred) ? preferred[i] : link_neg_rates[i - num_preferred].speed;
+
+        if (link_neg_supported(features, speed) == 0)
+            continue;
+
+        for (k = 0; k < num_speeds; k++)
+        {
+            if (speeds[k] == speed)
+                break;
+        }
+        if (k < num_speeds)
+            continue;
+
+        speeds[num_speeds++] = speed;
+    }
+
+    return num_speeds;
+}
+
+/**
+ * Try the rates in link_neg_order() order.
+ * try_speed() programs the rate and waits for the lock.
+ * Returns the rate the link came up at or a negative error.
+ * */
+int link_neg_run(uint32_t features, const int *preferred, int num_preferred,
+        int (*try_speed)(void *arg, int speed), void *arg)
+{
+    int speeds[LINK_NEG_MAX_RATES];
+    int num_speeds, ret = -ENOLINK, i;
+
+    num_speeds = link_neg_order(features, preferred, num_preferred, speeds);
+
+    for (i = 0; i < num_speeds; i++)
+    {
+        ret = try_speed(arg, speeds[i]);
+        if (ret >= 0)
+            return speeds[i];
+    }
+
+    return ret;
+}
+
+static int link_state_read(link_state_entry *entries)
+{
+    FILE *fp;
+    char line[128];
+    unsigned int deser_addr, ser_devid;
+    int num = 0;
+
+    if ((app_params.state_file == NULL) || (app_params.state_file[0] == '\0'))
+        return 0;
+
+    fp = fopen(app_params.state_file, "r");
+    if (fp == NULL)
+        return 0;
+
+    while ((num < LINK_STATE_MAX_ENTRIES) && (fgets(line, sizeof(line), fp) != NULL))
+    {
+        if (sscanf(line, "%d %x %x %d", &entries[num].bus, &deser_addr, &ser_devid,
+                    &entries[num].speed) != 4)
+        {
+            continue;
+        }
+
+        entries[num].deser_addr = deser_addr;
+        entries[num].ser_devid = ser_devid;
+        num++;
+    }
+
+    fclose(fp);
+
+    return num;
+}
+
+/**
+ * Last good rate for the pair, ser_devid 0 - for the serializer last
+ * seen behind the deserializer, while the one there now is not known
+ * yet. Returns 0 if none.
+ * */
+int link_state_load(int bus, uint8_t deser_addr, uint8_t ser_devid)
+{
+    link_state_entry entries[LINK_STATE_MAX_ENTRIES];
+    int num, i, speed = 0;
+
+    pthread_mutex_lock(&link_state_lock);
+    num = link_state_read(entries);
+    pthread_mutex_unlock(&link_state_lock);
+
+    for (i = 0; i < num; i++)
+    {
+        /* Oldest first, the last match is the most recent */
+        if ((entries[i].bus == bus) &&
+            (entries[i].deser_addr == deser_addr) &&
+            ((ser_devid == 0) || (entries[i].ser_devid == ser_devid)))
+        {
+            speed = entries[i].speed;
+        }
+    }
+
+    return speed;
+}
+
+static int link_state_update(int bus, uint8_t deser_addr, uint8_t ser_devid, int speed)
+{
+    link_state_entry entries[LINK_STATE_MAX_ENTRIES];
+    char tmp_name[256];
+    FILE *fp;
+    int num, i;
+
+    if ((app_params.state_file == NULL) || (app_params.state_file[0] == '\0'))
+        return 0;
+
+    num = link_state_read(entries);
+
+    for (i = 0; i < num; i++)
+    {
+        if ((entries[i].bus == bus) &&
+            (entries[i].deser_addr == deser_addr) &&
+            (entries[i].ser_devid == ser_devid))
+        {
+            break;
+        }
+    }
+
+    /* Entries are kept oldest first, the pair goes last */
+    if (i < num)
+    {
+        if ((i == num - 1) && (entries[i].speed == speed))
+            return 0;
+
+        memmove(&entries[i], &entries[i + 1], (num - i - 1) * sizeof(link_state_entry));
+        num--;
+    } else if (num == LINK_STATE_MAX_ENTRIES) {
+        memmove(&entries[0], &entries[1], (num - 1) * sizeof(link_state_entry));
+        num--;
+    }
+
+    i = num++;
+
+    entries[i].bus = bus;
+    entries[i].deser_addr = deser_addr;
+    entries[i].ser_devid = ser_devid;
+    entries[i].speed = speed;
+
+    /* Replace the file at once, a power cut must not leave half of it */
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", app_params.state_file);
+
+    fp = fopen(tmp_name, "w");
+    if (fp == NULL)
+        return -errno;
+
+    for (i = 0; i < num; i++)
+    {
+        fprintf(fp, "%d %02x %02x %d\n", entries[i].bus, entries[i].deser_addr,
+                entries[i].ser_devid, entries[i].speed);
+    }
+
+    if (fclose(fp) != 0)
+    {
+        remove(tmp_name);
+        return -EIO;
+    }
+
+    if (rename(tmp_name, app_params.state_file) < 0)
+        return -errno;
+
+    return 0;
+}
+
+int link_state_save(int bus, uint8_t deser_addr, uint8_t ser_devid, int speed)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&link_state_lock);
+    ret = link_state_update(bus, deser_addr, ser_devid, speed);
+    pthread_mutex_unlock(&link_state_lock);
+
+    return ret;
+}
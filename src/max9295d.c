@@ -23,66 +23,140 @@
 #define SER_CTX_CHECK(x) if (x == NULL) { return -EFAULT; }
 
 #define MIPI_RX_DELAY     (100 * 1000)
+/* VIDEO_TX2: PCLKDET (pipes X, Y) */
+#define VIDEO_TX_READY_REG  (0x0102)
+#define VIDEO_TX_READY_REG_Y (0x010A)
+#define VIDEO_TX_READY_MASK (0x80)
 #define MIPI_RST_TIME     (150 * 1000)
-#define LINK_WAIT_TIME    (20)
+#define LINK_WAIT_TIME_MS (2000)
+
+/* Port A feeds pipe X, port B pipe Y */
+#define MAX9295D_RX_PORTS   (2)
+
+static const reg_seq_entry max9295d_init_seq[] = {
+    /* DEV : REG2 | VID_TX_EN_X~U: Disabled */
+    SEQ_WRITE(0x0002, 0x03),
+    /* Enable LOCK_EN */
+    SEQ_UPDATE(0x0005, (1 << 7), (1 << 7)),
+    /* MIPI_RX : MIPI_RX0 | Port Configuration: 2x4, ports A and B */
+    SEQ_WRITE(0x0330, 0x06),
+    /* 400kHz I2C, 16ms timeout */
+    SEQ_WRITE(0x0040, 0x15),
+    SEQ_WRITE(0x0041, 0x55),
+};
 
 int max9295d_init(pserializer_ctx pctx)
 {
-    uint8_t reg8 = 0;
-
     SER_CTX_CHECK(pctx);
 
-    (void)reg8;
+    pctx->rx_port_mask = 0;
 
-    return 0;
+    return serializer_run_seq(pctx, max9295d_init_seq, ARRAY_SIZE(max9295d_init_seq));
 }
 
 int max9295d_start(pserializer_ctx pctx)
 {
+    uint8_t ports, fronttop0 = 0, fronttop9 = 0, reg2 = 0x03;
+
     SER_CTX_CHECK(pctx);
 
+    ports = (pctx->rx_port_mask != 0) ? pctx->rx_port_mask : 0x01;
+
+    if (ports & 0x01)
+    {
+        /* START_PORTA, START_PORTAX, VID_TX_EN_X */
+        fronttop0 |= 0x10;
+        fronttop9 |= 0x01;
+        reg2 |= 0x10;
+    }
+
+    if (ports & 0x02)
+    {
+        /* CLK_SELY: Port B, START_PORTB, START_PORTBY, VID_TX_EN_Y */
+        fronttop0 |= 0x20 | 0x02;
+        fronttop9 |= 0x20;
+        reg2 |= 0x20;
+    }
+
+    /* FRONTTOP : FRONTTOP_0 */
+    serializer_write_reg(pctx, 0x0308, fronttop0);
+    /* FRONTTOP : FRONTTOP_9 */
+    serializer_write_reg(pctx, 0x0311, fronttop9);
+
+    serializer_settle_ready(pctx, (ports & 0x01) ? VIDEO_TX_READY_REG : VIDEO_TX_READY_REG_Y,
+            VIDEO_TX_READY_MASK, VIDEO_TX_READY_MASK, MIPI_RX_DELAY);
+
+    /* DEV : REG2 | VID_TX_EN of the pipes in use */
+    serializer_write_reg(pctx, 0x0002, reg2);
+
     return 0;
 }
 
+/**
+ * Port A (PHY0, PHY1) takes bits 15:8 of lane_mapping and lane_polarity,
+ * port B (PHY2, PHY3) bits 7:0, as laid out in MIPI_RX2~5
+ * */
 int max9295d_set_mipi_rx_params(pserializer_ctx pctx,
         int port, int lanes, uint16_t lane_mapping, uint16_t lane_polarity, int skew_en, int tunnel_mode_en)
 {
-    uint8_t reg8 = 0;
+    uint8_t reg8 = 0, shift;
 
     SER_CTX_CHECK(pctx);
-    (void)port;
-    (void)lanes;
-    (void)lane_mapping;
-    (void)lane_polarity;
-    (void)skew_en;
-    (void)tunnel_mode_en;
-    (void)reg8;
 
-    return 0;
-}
+    if ((port < 0) || (port >= MAX9295D_RX_PORTS))
+        return -EINVAL;
 
-int max9295d_wait_for_link(pserializer_ctx pctx)
-{
-    uint8_t reg8 = 0;
-    int i;
+    if (tunnel_mode_en != 0)
+    {
+        /* MIPI_RX_EXT : EXT11 | Tun_Mode (Tunnel Mode): Enabled */
+        serializer_write_reg(pctx, 0x0383, 0x80);
+    } else {
+        /* Turn off Tunnel mode */
+        serializer_read_reg(pctx, 0x0383, &reg8);
+        reg8 &= 0x7F;
+        serializer_write_reg(pctx, 0x0383, reg8);
+
+        /* VC_SELX_L / VC_SELY_L to all */
+        serializer_write_reg(pctx, (port == 0) ? 0x0309 : 0x030B, 0xFF);
+    }
 
-    SER_CTX_CHECK(pctx);
+    /* MIPI_RX : MIPI_RX1 | ctrl0_num_lanes at 1:0, ctrl1_num_lanes at 5:4, deskew above each */
+    shift = (port == 0) ? 0 : 4;
+    serializer_read_reg(pctx, 0x0331, &reg8);
+    reg8 &= ~(0x07 << shift);
+    reg8 |= ((lanes - 1) & 0x03) << shift;
+    if (skew_en != 0) reg8 |= (0x04 << shift);
+    serializer_write_reg(pctx, 0x0331, reg8);
 
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0013, &reg8);
+    if (port == 0)
+    {
+        /* MIPI_RX : MIPI_RX2 | phy0_lane_map, phy1_lane_map */
+        serializer_write_reg(pctx, 0x0332, (lane_mapping >> 8) & 0xFF);
+        /* MIPI_RX : MIPI_RX4 | phy0_pol_map, phy1_pol_map */
+        serializer_write_reg(pctx, 0x0334, (lane_polarity >> 8) & 0xFF);
+    } else {
+        /* MIPI_RX : MIPI_RX3 | phy2_lane_map, phy3_lane_map */
+        serializer_write_reg(pctx, 0x0333, lane_mapping & 0xFF);
+        /* MIPI_RX : MIPI_RX5 | phy2_pol_map, phy3_pol_map */
+        serializer_write_reg(pctx, 0x0335, lane_polarity & 0xFF);
+    }
 
-    if (reg8 & 0x08) return 0;
+    /* LCRC on, VIDEO_TX0 of pipe X / Y */
+    serializer_read_reg(pctx, (port == 0) ? 0x0100 : 0x0108, &reg8);
+    reg8 |= (1 << 6);
+    serializer_write_reg(pctx, (port == 0) ? 0x0100 : 0x0108, reg8);
 
-    i = 0;
-    while(i++ < LINK_WAIT_TIME)
-    {
-        i2c_read_reg8a16(pctx->i2c_slave_address, 0x0013, &reg8);
+    pctx->rx_port_mask |= (1 << port);
 
-        if (reg8 & 0x08) return 0;
+    return 0;
+}
 
-        usleep(100 * 1000);
-    }
+int max9295d_wait_for_link(pserializer_ctx pctx)
+{
+    SER_CTX_CHECK(pctx);
 
-    return -1;
+    /* CTRL3 LOCKED */
+    return serializer_poll_reg(pctx, 0x0013, 0x08, 0x08, LINK_WAIT_TIME_MS, &pctx->link_lock_ms);
 }
 
 int max9295d_set_link_speed_gbps(pserializer_ctx pctx, int speed)
@@ -95,19 +169,19 @@ int max9295d_set_link_speed_gbps(pserializer_ctx pctx, int speed)
     {
     case 3:
         /* Enable 3G */
-        i2c_read_reg8a16(pctx->i2c_slave_address, 0x0001, &reg8);
+        serializer_read_reg(pctx, 0x0001, &reg8);
         reg8 &= ~0xC;
         reg8 |= 0x4;
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0001, reg8);
+        serializer_write_reg(pctx, 0x0001, reg8);
 
         printf("MAX9295D prepared for 3G.\r\n");
         break;
     case 6:
         /* Enable 6G */
-        i2c_read_reg8a16(pctx->i2c_slave_address, 0x0001, &reg8);
+        serializer_read_reg(pctx, 0x0001, &reg8);
         reg8 &= ~0xC;
         reg8 |= 0x8;
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0001, reg8);
+        serializer_write_reg(pctx, 0x0001, reg8);
 
         printf("MAX9295D prepared for 6G.\r\n");
         break;
@@ -125,96 +199,37 @@ int max9295d_reset_link(pserializer_ctx pctx)
     SER_CTX_CHECK(pctx);
 
     /* Reset one shot */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0010, 0x21);
+    serializer_write_reg(pctx, 0x0010, 0x21);
 
     return 0;
 }
 
-int max9295d_get_stats(pserializer_ctx pctx)
+int max9295d_get_stats(pserializer_ctx pctx, uint32_t groups)
 {
-    uint8_t reg8 = 0;
+    int ret;
 
     SER_CTX_CHECK(pctx);
 
     /* RX0 Counting Video packets only */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x002C, 0x01);
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0013, &reg8);
-    pctx->ser_stats[0].global_status = reg8 & 0x04 ? -1 : 0;
-    pctx->ser_stats[1].global_status = pctx->ser_stats[0].global_status;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0339, &reg8);
-    pctx->ser_stats[0].mipi_rx_l_lp_errors = reg8;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x033A, &reg8);
-    pctx->ser_stats[0].mipi_rx_l_hs_errors = reg8;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x033B, &reg8);
-    pctx->ser_stats[0].mipi_rx_h_lp_errors = reg8;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x033C, &reg8);
-    pctx->ser_stats[0].mipi_rx_h_hs_errors = reg8;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x033D, &reg8);
-    pctx->ser_stats[1].mipi_rx_l_lp_errors = reg8;
+    if (groups & STATS_GROUP_COUNTERS)
+        serializer_write_reg(pctx, 0x002C, 0x01);
 
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x033E, &reg8);
-    pctx->ser_stats[1].mipi_rx_l_hs_errors = reg8;
+    ret = serializer_read_stats(pctx, groups);
+    if (ret < 0)
+        return ret;
 
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x033F, &reg8);
-    pctx->ser_stats[1].mipi_rx_h_lp_errors = reg8;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0340, &reg8);
-    pctx->ser_stats[1].mipi_rx_h_hs_errors = reg8;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0341, &reg8);
-    pctx->ser_stats[0].ctrl1_csi_l_errors = reg8;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0342, &reg8);
-    pctx->ser_stats[0].ctrl1_csi_h_errors = reg8;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0343, &reg8);
-    pctx->ser_stats[1].ctrl1_csi_l_errors = reg8;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0344, &reg8);
-    pctx->ser_stats[1].ctrl1_csi_h_errors = reg8;
-
-    pctx->ser_stats[0].mipi_dphy_rx_count = -1;
-    pctx->ser_stats[0].mipi_pkt_processed = -1;
-    pctx->ser_stats[0].mipi_clk_rx_count  = -1;
-    pctx->ser_stats[1].mipi_dphy_rx_count = -1;
-    pctx->ser_stats[1].mipi_pkt_processed = -1;
-    pctx->ser_stats[1].mipi_clk_rx_count  = -1;
-
-    pctx->ser_stats[0].is_tunnel_mode = 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0102, &reg8);
-    pctx->ser_stats[0].tx_fifo_warn_flag        = reg8 & (1 << 4) ? 1 : 0;
-    pctx->ser_stats[0].tx_fifo_overflow_flag    = reg8 & (1 << 5) ? 1 : 0;
-    pctx->ser_stats[0].tx_pclk_drift_flag       = reg8 & (1 << 6) ? 1 : 0;
-    pctx->ser_stats[0].tx_pclk_det_flag         = reg8 & (1 << 7) ? 1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x010A, &reg8);
-    pctx->ser_stats[1].tx_fifo_warn_flag        = reg8 & (1 << 4) ? 1 : 0;
-    pctx->ser_stats[1].tx_fifo_overflow_flag    = reg8 & (1 << 5) ? 1 : 0;
-    pctx->ser_stats[1].tx_pclk_drift_flag       = reg8 & (1 << 6) ? 1 : 0;
-    pctx->ser_stats[1].tx_pclk_det_flag         = reg8 & (1 << 7) ? 1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0112, &reg8);
-    pctx->ser_stats[2].tx_fifo_warn_flag        = reg8 & (1 << 4) ? 1 : 0;
-    pctx->ser_stats[2].tx_fifo_overflow_flag    = reg8 & (1 << 5) ? 1 : 0;
-    pctx->ser_stats[2].tx_pclk_drift_flag       = reg8 & (1 << 6) ? 1 : 0;
-    pctx->ser_stats[2].tx_pclk_det_flag         = reg8 & (1 << 7) ? 1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x011A, &reg8);
-    pctx->ser_stats[3].tx_fifo_warn_flag        = reg8 & (1 << 4) ? 1 : 0;
-    pctx->ser_stats[3].tx_fifo_overflow_flag    = reg8 & (1 << 5) ? 1 : 0;
-    pctx->ser_stats[3].tx_pclk_drift_flag       = reg8 & (1 << 6) ? 1 : 0;
-    pctx->ser_stats[3].tx_pclk_det_flag         = reg8 & (1 << 7) ? 1 : 0;
+    if (groups & STATS_GROUP_COUNTERS)
+    {
+        pctx->ser_stats[0].mipi_dphy_rx_count = -1;
+        pctx->ser_stats[0].mipi_pkt_processed = -1;
+        pctx->ser_stats[0].mipi_clk_rx_count  = -1;
+        pctx->ser_stats[1].mipi_dphy_rx_count = -1;
+        pctx->ser_stats[1].mipi_pkt_processed = -1;
+        pctx->ser_stats[1].mipi_clk_rx_count  = -1;
+    }
 
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0025, &reg8);
-    pctx->ser_stats[0].global_pkt_count = reg8;
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0025, 0x00);
+    if (groups & STATS_GROUP_COUNTERS)
+        serializer_write_reg(pctx, 0x0025, 0x00);
 
     return 0;
 }
@@ -23,8 +23,12 @@
 #define DESER_CTX_CHECK(x) if (x == NULL) { return -EFAULT; }
 
 #define MIPI_TX_DELAY     (100 * 1000)
+/* BACKTOP1: CSIPLLY_LOCK of controller 1, next bit - of controller 2 */
+#define MIPI_TX_READY_REG   (0x0400)
+#define MIPI_TX_READY_MASK  (0x20)
+#define CSI_PORTS           (2)     /* 2x4 mode */
 #define MIPI_RST_TIME     (150 * 1000)
-#define LINK_WAIT_TIME    (20) /* 2 sec */
+#define LINK_WAIT_TIME_MS (2000)
 
 int max96724_init(pdeserializer_ctx pctx)
 {
@@ -35,13 +39,13 @@ int max96724_init(pdeserializer_ctx pctx)
     (void)reg8;
 
     /* RX0 Counting Video packets only */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x1004, 0x01);
+    deserializer_write_reg(pctx, 0x1004, 0x01);
  
     /* Coax drive */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0022, 0xFF);
+    deserializer_write_reg(pctx, 0x0022, 0xFF);
 
     /* GMSL2, Enable all links */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0006, 0xFF);
+    deserializer_write_reg(pctx, 0x0006, 0xFF);
 
     pctx->features = FEATURE_DES_6GBPS | FEATURE_DES_3GBPS;
 
@@ -52,10 +56,10 @@ int max96724_start(pdeserializer_ctx pctx)
 {
     DESER_CTX_CHECK(pctx);
 
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x040B, 0x02);
+    deserializer_write_reg(pctx, 0x040B, 0x02);
 
     /* VIDEO_PIPE_EN to 1 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x00F4, 0x1F);
+    deserializer_write_reg(pctx, 0x00F4, 0x1F);
 
     return 0;
 }
@@ -63,172 +67,187 @@ int max96724_start(pdeserializer_ctx pctx)
 int max96724_set_mipi_tx_params(pdeserializer_ctx pctx,
         int port, int lanes, uint16_t lane_mapping, uint16_t lane_polarity, int deskew_en, int out_freq, int tunnel_mode_en)
 {
-    uint8_t reg8 = 0;
+    uint8_t lanes_reg = 0, speed_reg = 0x20;
+    /* MIPI_TX registers of the controller driving the port */
+    uint16_t tx_base = MAX9672X_MIPI_TX_BASE(port);
+    int ret = 0;
 
     DESER_CTX_CHECK(pctx);
 
-    /* BACKTOP : BACKTOP12 | CSI_OUT_EN (CSI_OUT_EN): CSI output disabled */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x040B, 0x00);
-
-    /* VIDEO_PIPE_SEL stream Y -> Link A streamID 0, Z-> Link B steamID 1 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x00F0, 0x61);
-    /* VIDEO_PIPE_SEL stream X -> Link C streamID 2, U-> Link D steamID 3 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x00F1, 0xF8);
+    if ((port < 0) || (port >= CSI_PORTS))
+        return -EINVAL;
 
     /* MIPI_TX10: Set Lane count */
-    reg8 = ((lanes - 1) << 6);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x090A, reg8);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x094A, reg8);
-    
-    /* MIPI_PHY3 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x08A3, lane_mapping & 0xFF);
-    /* MIPI_PHY4 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x08A4, lane_mapping & 0xFF);
-    /* MIPI_PHY5 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x08A5, lane_polarity & 0x3F);
-    /* MIPI_PHY6 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x08A6, lane_polarity & 0x3F);
-
-    reg8 = 0x20;
+    lanes_reg = ((lanes - 1) << 6);
+
     if (out_freq <= 80) {
         /* 0 value */
     } else {
-        reg8 |= ((out_freq / 100) & 0x1F);
+        speed_reg |= ((out_freq / 100) & 0x1F);
+    }
+
+    /* 2x4 mode: port 0 (PHY0/PHY1) driven by controller 1, port 1 (PHY2/PHY3) by controller 2 */
+    static const reg_seq_entry common_seq[] = {
+        /* BACKTOP : BACKTOP12 | CSI_OUT_EN (CSI_OUT_EN): CSI output disabled */
+        SEQ_WRITE(0x040B, 0x00),
+        /* VIDEO_PIPE_SEL stream Y -> Link A streamID 0, Z-> Link B steamID 1 */
+        SEQ_WRITE(0x00F0, 0x61),
+        /* VIDEO_PIPE_SEL stream X -> Link C streamID 2, U-> Link D steamID 3 */
+        SEQ_WRITE(0x00F1, 0xF8),
+    };
+
+    const reg_seq_entry setup_seq[] = {
+        /* MIPI_TX10: Set Lane count */
+        SEQ_WRITE(tx_base + 0x0A, lanes_reg),
+        /* MIPI_PHY3/MIPI_PHY4: lane mapping of the PHY pair */
+        SEQ_WRITE(0x08A3 + port, lane_mapping & 0xFF),
+        /* MIPI_PHY5/MIPI_PHY6: lane polarity of the PHY pair */
+        SEQ_WRITE(0x08A5 + port, lane_polarity & 0x3F),
+        /* BACKTOP22/25 or BACKTOP28/31: Set MIPI TX speed of both PHYs of the port */
+        SEQ_WRITE(MAX9672X_PHY_RATE_REG(port), speed_reg),
+        SEQ_WRITE(MAX9672X_PHY_RATE_REG(port) + 3, speed_reg),
+    };
+
+    const reg_seq_entry tunnel_seq[] = {
+        /* MIPI_TX54 - Tunnel ON */
+        SEQ_WRITE(tx_base + 0x36, 0x09),
+    };
+
+    const reg_seq_entry deskew_seq[] = {
+        /* MIPI_TX3, MIPI_TX4 */
+        SEQ_WRITE(tx_base + 0x03, 0x81),
+        SEQ_WRITE(tx_base + 0x04, 0xB9),
+        /* MIPI_TX50 - VC0 only */
+        SEQ_WRITE(tx_base + 0x32, 0x80),
+    };
+
+    static const reg_seq_entry report_seq[] = {
+        /* MIPI PHY16 - Reporting on */
+        SEQ_WRITE(0x08B0, 0x78),
+        /* LCRC on */
+        SEQ_UPDATE(0x0100, 0x02, 0x02),
+        SEQ_UPDATE(0x0112, 0x02, 0x02),
+        SEQ_UPDATE(0x0124, 0x02, 0x02),
+        SEQ_UPDATE(0x0136, 0x02, 0x02),
+    };
+
+    /* Send the whole setup as one transaction */
+    i2c_batch_begin(pctx->bus);
+
+    if (port == 0)
+    {
+        deserializer_run_seq(pctx, common_seq, ARRAY_SIZE(common_seq));
     }
-    /* BACKTOP22: Set MIPI TX speed */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0415, reg8);
-    /* BACKTOP25: Set MIPI TX speed */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0418, reg8);
-    /* BACKTOP28: Set MIPI TX speed */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x041B, reg8);
-    /* BACKTOP31: Set MIPI TX speed */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x041E, reg8);
+
+    deserializer_run_seq(pctx, setup_seq, ARRAY_SIZE(setup_seq));
 
     if (tunnel_mode_en != 0)
     {
-        /* MIPI_TX54 - Tunnel ON */
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0936, 0x09);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0976, 0x09);
-        /* Reset link */
-        //i2c_write_reg8a16(pctx->i2c_slave_address, 0x0010, 0x31);
-        //usleep(500 * 100);
+        deserializer_run_seq(pctx, tunnel_seq, ARRAY_SIZE(tunnel_seq));
     }
 
-    usleep(MIPI_TX_DELAY);
+    i2c_batch_end(pctx->bus);
+
+    deserializer_settle_ready(pctx, MIPI_TX_READY_REG, MIPI_TX_READY_MASK << port,
+            MIPI_TX_READY_MASK << port, MIPI_TX_DELAY);
+
+    i2c_batch_begin(pctx->bus);
 
     if (deskew_en != 0) {
-        /* MIPI_TX3 */
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0903, 0x81);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0943, 0x81);
-        /* MIPI_TX4 */
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0904, 0xB9);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0944, 0xB9);
-        /* MIPI_TX50 - VC0 only */
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0932, 0x80);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0972, 0x80);
+        deserializer_run_seq(pctx, deskew_seq, ARRAY_SIZE(deskew_seq));
     }
-    /* MIPI PHY16 - Reporting on */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x08B0, 0x78);
-
-    /* LCRC on */
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0100, &reg8);
-    reg8 |= (1 << 1);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0100, reg8);
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0112, &reg8);
-    reg8 |= (1 << 1);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0112, reg8);
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0124, &reg8);
-    reg8 |= (1 << 1);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0124, reg8);
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0136, &reg8);
-    reg8 |= (1 << 1);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0136, reg8);
 
-    return 0;
+    if (port == 0)
+    {
+        ret = deserializer_run_seq(pctx, report_seq, ARRAY_SIZE(report_seq));
+    }
+
+    i2c_batch_end(pctx->bus);
+
+    return ret;
 }
 
-int max96724_wait_for_link(pdeserializer_ctx pctx)
+/* Links the link functions act on */
+static uint8_t max96724_link_mask(pdeserializer_ctx pctx)
+{
+    return (pctx->link_mask != 0) ? (pctx->link_mask & 0x0F) : 0x0F;
+}
+
+int max96724_get_link_status(pdeserializer_ctx pctx, uint8_t *locked_mask)
 {
+    /* CTRL3, CTRL12, CTRL13, CTRL14 */
+    static const uint16_t lock_regs[4] = { 0x001A, 0x000A, 0x000B, 0x000C };
     uint8_t reg8a[4];
-    int i;
+    int ret, i;
 
     DESER_CTX_CHECK(pctx);
 
-    /* CTRL3 */
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x001A, &reg8a[0]);
-    /* CTRL12 */
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x000A, &reg8a[1]);
-    /* CTRL13 */
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x000B, &reg8a[2]);
-    /* CTRL14 */
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x000C, &reg8a[3]);
-
-    if ((reg8a[0] & 0x08) && 
-        (reg8a[1] & 0x08) && 
-        (reg8a[2] & 0x08) && 
-        (reg8a[3] & 0x08))
+    ret = deserializer_read_regs(pctx, lock_regs, reg8a, 4);
+    if (ret < 0)
+        return ret;
+
+    *locked_mask = 0;
+    for (i = 0; i < 4; i++)
     {
-        return 0;
+        if (reg8a[i] & 0x08)
+            *locked_mask |= (1 << i);
     }
 
-    i = 0;
-    while(i++ < LINK_WAIT_TIME)
-    {
-        /* CTRL3 */
-        i2c_read_reg8a16(pctx->i2c_slave_address, 0x001A, &reg8a[0]);
-        /* CTRL12 */
-        i2c_read_reg8a16(pctx->i2c_slave_address, 0x000A, &reg8a[1]);
-        /* CTRL13 */
-        i2c_read_reg8a16(pctx->i2c_slave_address, 0x000B, &reg8a[2]);
-        /* CTRL14 */
-        i2c_read_reg8a16(pctx->i2c_slave_address, 0x000C, &reg8a[3]);
-
-        if ((reg8a[0] & 0x08) && 
-            (reg8a[1] & 0x08) && 
-            (reg8a[2] & 0x08) && 
-            (reg8a[3] & 0x08))
-        {
-            break;
-        }
+    return 0;
+}
 
-        usleep(100 * 1000);
-    }
+typedef struct max96724_link_poll_ {
+    pdeserializer_ctx   pctx;
+    uint8_t             mask;
+    uint8_t             locked;
+} max96724_link_poll;
 
-    if ((reg8a[0] & 0x08) ||
-        (reg8a[1] & 0x08) || 
-        (reg8a[2] & 0x08) || 
-        (reg8a[3] & 0x08))
-    {
+static int max96724_links_locked(void *arg)
+{
+    max96724_link_poll *ppoll = (max96724_link_poll *)arg;
+
+    if (max96724_get_link_status(ppoll->pctx, &ppoll->locked) < 0)
+        return 0;
+
+    return ((ppoll->locked & ppoll->mask) == ppoll->mask);
+}
+
+int max96724_wait_for_link(pdeserializer_ctx pctx)
+{
+    max96724_link_poll link_poll;
+
+    DESER_CTX_CHECK(pctx);
+
+    memset(&link_poll, 0, sizeof(link_poll));
+    link_poll.pctx = pctx;
+    link_poll.mask = max96724_link_mask(pctx);
+
+    if (poll_until(pctx->bus, max96724_links_locked, &link_poll, LINK_WAIT_TIME_MS, &pctx->link_lock_ms) == 0)
+        return 0;
+
+    /* Not all links came up, any one is enough unless links were picked */
+    if ((pctx->link_mask == 0) && (link_poll.locked != 0))
         return 0;
-    }
 
     return -1;
 }
 
 int max96724_set_link_speed_gbps(pdeserializer_ctx pctx, int speed)
 {
-    uint8_t reg8 = 0;
+    uint8_t reg8 = 0, rate = 0, mask;
+    int link;
 
     DESER_CTX_CHECK(pctx);
 
-    /* Keep link in reset */
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0018, &reg8);
-    reg8 |= (0xF << 4);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0018, reg8);
+    mask = max96724_link_mask(pctx);
 
     switch(speed)
     {
     case 3:
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0010, 0x11);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0011, 0x11);
-        
-        printf("MAX96724 prepared for 3G.\r\n");
+        rate = 1;
         break;
     case 6:
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0010, 0x22);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0011, 0x22);
-        
-        printf("MAX96724 prepared for 6G.\r\n");
+        rate = 2;
         break;
     case 12:
         return -EINVAL;
@@ -236,10 +255,32 @@ int max96724_set_link_speed_gbps(pdeserializer_ctx pctx, int speed)
         break;
     }
 
-    /* Release link */
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0018, &reg8);
-    reg8 &= ~(0xF << 4);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0018, reg8);
+    /* Keep links in reset */
+    deserializer_read_reg(pctx, 0x0018, &reg8);
+    reg8 |= (mask << 4);
+    deserializer_write_reg(pctx, 0x0018, reg8);
+
+    if (rate != 0)
+    {
+        /* REG10, REG11: RX_RATE of links A, B and C, D at bits 1:0 and 5:4 */
+        for (link = 0; link < 4; link++)
+        {
+            if (!(mask & (1 << link)))
+                continue;
+
+            deserializer_read_reg(pctx, 0x0010 + link / 2, &reg8);
+            reg8 &= ~(0x03 << ((link % 2) * 4));
+            reg8 |= rate << ((link % 2) * 4);
+            deserializer_write_reg(pctx, 0x0010 + link / 2, reg8);
+        }
+
+        printf("MAX96724 prepared for %dG.\r\n", speed);
+    }
+
+    /* Release links */
+    deserializer_read_reg(pctx, 0x0018, &reg8);
+    reg8 &= ~(mask << 4);
+    deserializer_write_reg(pctx, 0x0018, reg8);
 
     return 0;
 }
@@ -251,77 +292,24 @@ int max96724_reset_link(pdeserializer_ctx pctx)
     DESER_CTX_CHECK(pctx);
 
     /* Reset one shot A~D */
-    i2c_read_reg8a16(pctx->i2c_slave_address,  0x0018, &reg8);
-    reg8 |= (0x0F);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0018, reg8);
+    deserializer_read_reg(pctx, 0x0018, &reg8);
+    reg8 |= max96724_link_mask(pctx);
+    deserializer_write_reg(pctx, 0x0018, reg8);
 
     return 0;
 }
 
-int max96724_get_stats(pdeserializer_ctx pctx)
+/**
+ * Route the remote control channel to one link, -1 - to all of them.
+ * Serializers sharing an address are reached one at a time this way.
+ * */
+int max96724_select_link(pdeserializer_ctx pctx, int link)
 {
-    uint8_t reg8 = 0;
-
     DESER_CTX_CHECK(pctx);
 
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x001A, &reg8);
-    pctx->deser_stats[0].global_status = reg8 & 0x04 ? -1 : 0;
-    pctx->deser_stats[1].global_status = pctx->deser_stats[0].global_status;
-    pctx->deser_stats[2].global_status = pctx->deser_stats[0].global_status;
-    pctx->deser_stats[3].global_status = pctx->deser_stats[0].global_status;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x002A, &reg8);
-    pctx->deser_stats[0].remote_error_flag = reg8 & (1 << 1) ? 1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0108, &reg8);
-    pctx->deser_stats[0].video_rx_blk_len_err_flag    = (reg8 & 0x80) ? 1 : 0;
-    pctx->deser_stats[0].video_pipeline_locked_flag   = (reg8 & 0x40) ? 1 : 0;
-    pctx->deser_stats[0].sufficient_video_rx_thr_flag = (reg8 & 0x20) ? 1 : 0;
-    pctx->deser_stats[0].video_seq_error_flag         = (reg8 & 0x10) ? 1 : 0;
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x011A, &reg8);
-    pctx->deser_stats[1].video_rx_blk_len_err_flag    = (reg8 & 0x80) ? 1 : 0;
-    pctx->deser_stats[1].video_pipeline_locked_flag   = (reg8 & 0x40) ? 1 : 0;
-    pctx->deser_stats[1].sufficient_video_rx_thr_flag = (reg8 & 0x20) ? 1 : 0;
-    pctx->deser_stats[1].video_seq_error_flag         = (reg8 & 0x10) ? 1 : 0;
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x012C, &reg8);
-    pctx->deser_stats[2].video_rx_blk_len_err_flag    = (reg8 & 0x80) ? 1 : 0;
-    pctx->deser_stats[2].video_pipeline_locked_flag   = (reg8 & 0x40) ? 1 : 0;
-    pctx->deser_stats[2].sufficient_video_rx_thr_flag = (reg8 & 0x20) ? 1 : 0;
-    pctx->deser_stats[2].video_seq_error_flag         = (reg8 & 0x10) ? 1 : 0;
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x013E, &reg8);
-    pctx->deser_stats[3].video_rx_blk_len_err_flag    = (reg8 & 0x80) ? 1 : 0;
-    pctx->deser_stats[3].video_pipeline_locked_flag   = (reg8 & 0x40) ? 1 : 0;
-    pctx->deser_stats[3].sufficient_video_rx_thr_flag = (reg8 & 0x20) ? 1 : 0;
-    pctx->deser_stats[2].video_seq_error_flag         = (reg8 & 0x10) ? 1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x040A, &reg8);
-    pctx->deser_stats[0].video_rx_overflow_flag = (reg8 & 0x10) ? 1 : 0;
-    pctx->deser_stats[1].video_rx_overflow_flag = (reg8 & 0x20) ? 1 : 0;
-    pctx->deser_stats[2].video_rx_overflow_flag = (reg8 & 0x40) ? 1 : 0;
-    pctx->deser_stats[3].video_rx_overflow_flag = (reg8 & 0x80) ? 1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x08D0, &reg8);
-    pctx->deser_stats[0].csi2_tx_packets_count = reg8 & 0x0F;
-    pctx->deser_stats[1].csi2_tx_packets_count = (reg8 >> 4) & 0x0F;
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x08D1, &reg8);
-    pctx->deser_stats[2].csi2_tx_packets_count = reg8 & 0x0F;
-    pctx->deser_stats[3].csi2_tx_packets_count = (reg8 >> 4) & 0x0F;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x08D2, &reg8);
-    pctx->deser_stats[0].mipi_phy_packets_count = reg8 & 0x0F;
-    pctx->deser_stats[1].mipi_phy_packets_count = (reg8 >> 4) & 0x0F;
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x08D3, &reg8);
-    pctx->deser_stats[2].mipi_phy_packets_count = reg8 & 0x0F;
-    pctx->deser_stats[3].mipi_phy_packets_count = (reg8 >> 4) & 0x0F;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0040, &reg8);
-    pctx->deser_stats[0].global_pkt_count = reg8;
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0041, &reg8);
-    pctx->deser_stats[1].global_pkt_count = reg8;
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0042, &reg8);
-    pctx->deser_stats[2].global_pkt_count = reg8;
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0043, &reg8);
-    pctx->deser_stats[3].global_pkt_count = reg8;
+    /* REG3: DIS_REM_CC_A~D at bits 0, 2, 4, 6 */
+    if (link < 0)
+        return deserializer_write_reg(pctx, 0x0003, 0x00);
 
-    return 0;
+    return deserializer_write_reg(pctx, 0x0003, 0x55 & ~(1 << (2 * link)));
 }
@@ -23,8 +23,12 @@
 #define DESER_CTX_CHECK(x) if (x == NULL) { return -EFAULT; }
 
 #define MIPI_TX_DELAY     (100 * 1000)
+/* BACKTOP1: CSIPLLY_LOCK (controller 1), CSIPLLZ_LOCK (controller 2) next to it */
+#define MIPI_TX_READY_REG   (0x0308)
+#define MIPI_TX_READY_MASK  (0x20)
+#define CSI_PORTS           (2)
 #define MIPI_RST_TIME     (150 * 1000)
-#define LINK_WAIT_TIME    (20) /* 2 sec */
+#define LINK_WAIT_TIME_MS (2000)
 
 int max96792_init(pdeserializer_ctx pctx)
 {
@@ -34,10 +38,10 @@ int max96792_init(pdeserializer_ctx pctx)
     (void)reg8;
 
     /* RX0 Counting Video packets only */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x002C, 0x01);
+    deserializer_write_reg(pctx, 0x002C, 0x01);
  
     /* Coax drive */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0011, 0x0F);
+    deserializer_write_reg(pctx, 0x0011, 0x0F);
 
     pctx->features = FEATURE_DES_12GBPS | FEATURE_DES_6GBPS;
 
@@ -48,10 +52,10 @@ int max96792_start(pdeserializer_ctx pctx)
 {
     DESER_CTX_CHECK(pctx);
 
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0313, 0x02);
+    deserializer_write_reg(pctx, 0x0313, 0x02);
 
     /* VIDEO_PIPE_EN to 1 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0160, 0x03);
+    deserializer_write_reg(pctx, 0x0160, 0x03);
 
     return 0;
 }
@@ -60,27 +64,31 @@ int max96792_set_mipi_tx_params(pdeserializer_ctx pctx,
         int port, int lanes, uint16_t lane_mapping, uint16_t lane_polarity, int deskew_en, int out_freq, int tunnel_mode_en)
 {
     uint8_t reg8 = 0;
+    /* MIPI_TX registers of controller 1 (port 0) or 2 (port 1) */
+    uint16_t tx_base = 0x0440 + 0x40 * port;
 
     DESER_CTX_CHECK(pctx);
 
-    /* BACKTOP : BACKTOP12 | CSI_OUT_EN (CSI_OUT_EN): CSI output disabled */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0313, 0x00);
+    if ((port < 0) || (port >= CSI_PORTS))
+        return -EINVAL;
 
-    /* VIDEO_PIPE_SEL stream Y -> Link A streamID 0, Z-> Link B steamID 1 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0161, 0x28);
+    if (port == 0)
+    {
+        /* BACKTOP : BACKTOP12 | CSI_OUT_EN (CSI_OUT_EN): CSI output disabled */
+        deserializer_write_reg(pctx, 0x0313, 0x00);
+
+        /* VIDEO_PIPE_SEL stream Y -> Link A streamID 0, Z-> Link B steamID 1 */
+        deserializer_write_reg(pctx, 0x0161, 0x28);
+    }
 
     /* MIPI_TX10: Set Lane count */
     reg8 = ((lanes - 1) << 6) | 0x10;
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x044A, reg8);
+    deserializer_write_reg(pctx, tx_base + 0x0A, reg8);
     
-    /* MIPI_PHY3 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0333, lane_mapping & 0xFF);
-    /* MIPI_PHY4 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0334, lane_mapping & 0xFF);
-    /* MIPI_PHY5 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0335, lane_polarity & 0x3F);
-    /* MIPI_PHY6 */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0336, lane_polarity & 0x3F);
+    /* MIPI_PHY3/MIPI_PHY4: lane mapping of the port */
+    deserializer_write_reg(pctx, 0x0333 + port, lane_mapping & 0xFF);
+    /* MIPI_PHY5/MIPI_PHY6: lane polarity of the port */
+    deserializer_write_reg(pctx, 0x0335 + port, lane_polarity & 0x3F);
 
     reg8 = 0x20;
     if (out_freq <= 80) {
@@ -88,63 +96,50 @@ int max96792_set_mipi_tx_params(pdeserializer_ctx pctx,
     } else {
         reg8 |= ((out_freq / 100) & 0x1F);
     }
-    /* BACKTOP22: Set MIPI TX speed */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x031D, reg8);
-    /* BACKTOP25: Set MIPI TX speed */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0320, reg8);
+    /* BACKTOP22/BACKTOP25: Set MIPI TX speed */
+    deserializer_write_reg(pctx, 0x031D + 3 * port, reg8);
 
     if (tunnel_mode_en != 0)
     {
         /* MIPI_TX52 - Tunnel ON */
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0474, 0x09);
+        deserializer_write_reg(pctx, tx_base + 0x34, 0x09);
         /* Reset link */
-        //i2c_write_reg8a16(pctx->i2c_slave_address, 0x0010, 0x31);
+        //deserializer_write_reg(pctx, 0x0010, 0x31);
         //usleep(500 * 100);
     }
 
-    usleep(MIPI_TX_DELAY);
+    deserializer_settle_ready(pctx, MIPI_TX_READY_REG, MIPI_TX_READY_MASK << port,
+            MIPI_TX_READY_MASK << port, MIPI_TX_DELAY);
 
     if (deskew_en != 0) {
         /* MIPI_TX3 */
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0443, 0x81);
+        deserializer_write_reg(pctx, tx_base + 0x03, 0x81);
         /* MIPI_TX4 */
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0444, 0xB9);
+        deserializer_write_reg(pctx, tx_base + 0x04, 0xB9);
         /* MIPI_TX50 - VC0 only */
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0472, 0x80);
+        deserializer_write_reg(pctx, tx_base + 0x32, 0x80);
     }
+
+    if (port != 0)
+        return 0;
+
     /* MIPI PHY16 - Reporting on */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0340, 0x39);
+    deserializer_write_reg(pctx, 0x0340, 0x39);
 
     /* LCRC on */
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0112, &reg8);
+    deserializer_read_reg(pctx, 0x0112, &reg8);
     reg8 |= (1 << 1);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0112, reg8);
+    deserializer_write_reg(pctx, 0x0112, reg8);
 
     return 0;
 }
 
 int max96792_wait_for_link(pdeserializer_ctx pctx)
 {
-    uint8_t reg8 = 0;
-    int i;
-
     DESER_CTX_CHECK(pctx);
 
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0013, &reg8);
-
-    if (reg8 & 0x08) return 0;
-
-    i = 0;
-    while(i++ < LINK_WAIT_TIME)
-    {
-        i2c_read_reg8a16(pctx->i2c_slave_address, 0x0013, &reg8);
-
-        if (reg8 & 0x08) return 0;
-
-        usleep(100 * 1000);
-    }
-
-    return -1;
+    /* CTRL3 LOCKED */
+    return deserializer_poll_reg(pctx, 0x0013, 0x08, 0x08, LINK_WAIT_TIME_MS, &pctx->link_lock_ms);
 }
 
 int max96792_set_link_speed_gbps(pdeserializer_ctx pctx, int speed)
@@ -154,57 +149,57 @@ int max96792_set_link_speed_gbps(pdeserializer_ctx pctx, int speed)
     DESER_CTX_CHECK(pctx);
 
     /* Keep link in reset */
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0010, &reg8);
+    deserializer_read_reg(pctx, 0x0010, &reg8);
     reg8 |= (1 << 6);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0010, reg8);
+    deserializer_write_reg(pctx, 0x0010, reg8);
 
     switch(speed)
     {
     case 3:
         /* Enable 3G */
-        i2c_read_reg8a16(pctx->i2c_slave_address, 0x0001, &reg8);
+        deserializer_read_reg(pctx, 0x0001, &reg8);
         reg8 &= ~0x3;
         reg8 |= (1 << 0);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0001, reg8);
+        deserializer_write_reg(pctx, 0x0001, reg8);
 
         printf("MAX96792A prepared for 3G.\r\n");
         break;
     case 6:
         /* Enable 6G */
-        i2c_read_reg8a16(pctx->i2c_slave_address, 0x0001, &reg8);
+        deserializer_read_reg(pctx, 0x0001, &reg8);
         reg8 &= ~0x3;
         reg8 |= (2 << 0);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0001, reg8);
+        deserializer_write_reg(pctx, 0x0001, reg8);
 
         /* Disable FEC */
-        i2c_read_reg8a16(pctx->i2c_slave_address,  0x0028, &reg8);
+        deserializer_read_reg(pctx, 0x0028, &reg8);
         reg8 &= ~(1 << 1);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0028, reg8);
+        deserializer_write_reg(pctx, 0x0028, reg8);
 
         /* Enable GMSL2 */
-        i2c_read_reg8a16(pctx->i2c_slave_address,  0x0004, &reg8);
+        deserializer_read_reg(pctx, 0x0004, &reg8);
         reg8 &= ~(3 << 6);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0004, reg8);
+        deserializer_write_reg(pctx, 0x0004, reg8);
         
 
         printf("MAX96792A prepared for 6G.\r\n");
         break;
     case 12:
         /* Enable 12G */
-        i2c_read_reg8a16(pctx->i2c_slave_address, 0x0001, &reg8);
+        deserializer_read_reg(pctx, 0x0001, &reg8);
         reg8 &= ~0x3;
         reg8 |= (3 << 0);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0001, reg8);
+        deserializer_write_reg(pctx, 0x0001, reg8);
 
         /* Enable FEC */
-        i2c_read_reg8a16(pctx->i2c_slave_address,  0x0028, &reg8);
+        deserializer_read_reg(pctx, 0x0028, &reg8);
         reg8 |= (1 << 1);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0028, reg8);
+        deserializer_write_reg(pctx, 0x0028, reg8);
 
         /* Disable GMSL2 */
-        i2c_read_reg8a16(pctx->i2c_slave_address,  0x0004, &reg8);
+        deserializer_read_reg(pctx, 0x0004, &reg8);
         reg8 |= (3 << 6);
-        i2c_write_reg8a16(pctx->i2c_slave_address, 0x0004, reg8);
+        deserializer_write_reg(pctx, 0x0004, reg8);
 
         printf("MAX96792A prepared for 12G.\r\n");
         break;
@@ -213,9 +208,9 @@ int max96792_set_link_speed_gbps(pdeserializer_ctx pctx, int speed)
     }
 
     /* Release link */
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0010, &reg8);
+    deserializer_read_reg(pctx, 0x0010, &reg8);
     reg8 &= ~(1 << 6);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0010, reg8);
+    deserializer_write_reg(pctx, 0x0010, reg8);
 
     return 0;
 }
@@ -227,69 +222,34 @@ int max96792_reset_link(pdeserializer_ctx pctx)
     DESER_CTX_CHECK(pctx);
 
     /* Reset one shot A */
-    i2c_read_reg8a16(pctx->i2c_slave_address,  0x0010, &reg8);
+    deserializer_read_reg(pctx, 0x0010, &reg8);
     reg8 |= (1 << 5);
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0010, reg8);
+    deserializer_write_reg(pctx, 0x0010, reg8);
 
     /* Reset one shot B */
-    //i2c_read_reg8a16(pctx->i2c_slave_address,  0x0012, &reg8);
+    //deserializer_read_reg(pctx, 0x0012, &reg8);
     //reg8 |= (1 << 5);
-    //i2c_write_reg8a16(pctx->i2c_slave_address, 0x0012, reg8);
+    //deserializer_write_reg(pctx, 0x0012, reg8);
 
     return 0;
 }
 
-int max96792_get_stats(pdeserializer_ctx pctx)
+int max96792_get_stats(pdeserializer_ctx pctx, uint32_t groups)
 {
-    uint8_t reg8 = 0;
+    int ret;
 
     DESER_CTX_CHECK(pctx);
 
     /* RX0 Counting Video packets only */
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x002C, 0x01);
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0013, &reg8);
-    pctx->deser_stats[0].global_status = reg8 & 0x04 ? -1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x001B, &reg8);
-    pctx->deser_stats[0].remote_error_flag = reg8 & (1 << 5) ? 1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x011A, &reg8);
-    pctx->deser_stats[0].video_rx_blk_len_err_flag    = (reg8 & 0x80) ? 1 : 0;
-    pctx->deser_stats[0].video_pipeline_locked_flag   = (reg8 & 0x40) ? 1 : 0;
-    pctx->deser_stats[0].sufficient_video_rx_thr_flag = (reg8 & 0x20) ? 1 : 0;
-    pctx->deser_stats[0].video_seq_error_flag         = (reg8 & 0x10) ? 1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x012C, &reg8);
-    pctx->deser_stats[1].video_rx_blk_len_err_flag    = (reg8 & 0x80) ? 1 : 0;
-    pctx->deser_stats[1].video_pipeline_locked_flag   = (reg8 & 0x40) ? 1 : 0;
-    pctx->deser_stats[1].sufficient_video_rx_thr_flag = (reg8 & 0x20) ? 1 : 0;
-    pctx->deser_stats[1].video_seq_error_flag         = (reg8 & 0x10) ? 1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x011C, &reg8);
-    pctx->deser_stats[0].video_rx_overflow_flag = (reg8 & 0x80) ? 1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x012E, &reg8);
-    pctx->deser_stats[1].video_rx_overflow_flag = (reg8 & 0x80) ? 1 : 0;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0341, &reg8);
-    pctx->deser_stats[0].video_rx_tun_overflow_flag = reg8 & 1;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0342, &reg8);
-    pctx->deser_stats[0].csi2_tx_packets_count = reg8 & 0x0F;
-    pctx->deser_stats[1].csi2_tx_packets_count = (reg8 >> 4) & 0x0F;
-
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0344, &reg8);
-    pctx->deser_stats[0].mipi_phy_packets_count = reg8;
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0345, &reg8);
-    pctx->deser_stats[1].mipi_phy_packets_count = reg8;
+    if (groups & STATS_GROUP_COUNTERS)
+        deserializer_write_reg(pctx, 0x002C, 0x01);
 
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0025, &reg8);
-    pctx->deser_stats[0].global_pkt_count = reg8;
-    i2c_write_reg8a16(pctx->i2c_slave_address, 0x0025, 0x00);
+    ret = deserializer_read_stats(pctx, groups);
+    if (ret < 0)
+        return ret;
 
-    i2c_read_reg8a16(pctx->i2c_slave_address, 0x0474, &reg8);
-    pctx->deser_stats[0].video_tunnel_flag = reg8 & (1 << 0) ? 1 : 0;
+    if (groups & STATS_GROUP_COUNTERS)
+        deserializer_write_reg(pctx, 0x0025, 0x00);
 
     return 0;
 }
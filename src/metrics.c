@@ -0,0 +1,434 @@
+/**
+ * @file   metrics.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  OpenMetrics exporter of the monitor stats on a local socket.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "serdes_head.h"
+
+#define METRICS_MAX_CLIENTS     (8)
+#define METRICS_REQUEST_SIZE    (1024)
+
+#define METRICS_HEADER \
+    "HTTP/1.0 200 OK\r\n" \
+    "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n" \
+    "Connection: close\r\n" \
+    "Content-Length: %zu\r\n\r\n"
+
+#define METRICS_NOT_FOUND \
+    "HTTP/1.0 404 Not Found\r\n" \
+    "Content-Type: text/plain\r\n" \
+    "Connection: close\r\n\r\n" \
+    "Not found, try /metrics\n"
+
+#define METRICS_EOF     "# EOF\n"
+
+/* Family of metrics, the samples of each chain are kept under it */
+typedef struct metrics_family_ {
+    const char  *name;
+    const char  *type;
+    const char  *help;
+} metrics_family;
+
+typedef struct metrics_client_ {
+    int         fd;
+    char        request[METRICS_REQUEST_SIZE];
+    size_t      request_len;
+    char        *response;      /* NULL - still reading the request */
+    size_t      response_len;
+    size_t      sent;
+} metrics_client;
+
+static const metrics_family metrics_families[METRICS_FAMILIES] = {
+    [METRICS_LINK_SPEED] = { "gmsl_link_speed_gbps", "gauge",
+            "Rate the GMSL link locked at, 0 - down" },
+    [METRICS_FLAG]       = { "gmsl_flag", "gauge",
+            "Lock and error flags of a chip port, 1 - set" },
+    [METRICS_COUNTER]    = { "gmsl_packets", "counter",
+            "Packet and error counters of a chip port, extended to 64 bits" },
+    [METRICS_RATE]       = { "gmsl_packet_rate", "gauge",
+            "Counter change per second over the last counters period" },
+};
+
+/* Samples rendered by the monitors, per chain and family */
+static char *metrics_text[SERDES_MAX_CHAINS][METRICS_FAMILIES];
+static size_t metrics_len[SERDES_MAX_CHAINS][METRICS_FAMILIES];
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static metrics_client metrics_clients[METRICS_MAX_CLIENTS];
+static pthread_t metrics_thread;
+static int metrics_listen_fd = -1;
+static int metrics_stop_fd[2] = { -1, -1 };
+static const char *metrics_unix_path;
+
+/**
+ * Replace the samples of a family of a chain, the text (malloc'ed) is
+ * taken over
+ * */
+void metrics_update(int chain, int family, char *text, size_t len)
+{
+    char *pold;
+
+    if ((chain < 0) || (chain >= SERDES_MAX_CHAINS) || (family < 0) || (family >= METRICS_FAMILIES))
+    {
+        free(text);
+        return;
+    }
+
+    pthread_mutex_lock(&metrics_lock);
+    pold = metrics_text[chain][family];
+    metrics_text[chain][family] = text;
+    metrics_len[chain][family] = len;
+    pthread_mutex_unlock(&metrics_lock);
+
+    free(pold);
+}
+
+/**
+ * Whole exposition with the HTTP header: the rendered samples are only
+ * copied, a scrape never reaches the bus
+ * */
+static char *metrics_render(size_t *plen)
+{
+    char header[160], *pbuf, *p;
+    size_t body_len = strlen(METRICS_EOF), header_len;
+    int chain, family;
+
+    pthread_mutex_lock(&metrics_lock);
+
+    for (family = 0; family < METRICS_FAMILIES; family++)
+    {
+        body_len += snprintf(NULL, 0, "# TYPE %s %s\n# HELP %s %s\n",
+                metrics_families[family].name, metrics_families[family].type,
+                metrics_families[family].name, metrics_families[family].help);
+        for (chain = 0; chain < SERDES_MAX_CHAINS; chain++)
+            body_len += metrics_len[chain][family];
+    }
+
+    header_len = snprintf(header, sizeof(header), METRICS_HEADER, body_len);
+
+    pbuf = malloc(header_len + body_len + 1);
+    if (pbuf == NULL)
+    {
+        pthread_mutex_unlock(&metrics_lock);
+        return NULL;
+    }
+
+    p = pbuf;
+    memcpy(p, header, header_len);
+    p += header_len;
+
+    for (family = 0; family < METRICS_FAMILIES; family++)
+    {
+        p += sprintf(p, "# TYPE %s %s\n# HELP %s %s\n",
+                metrics_families[family].name, metrics_families[family].type,
+                metrics_families[family].name, metrics_families[family].help);
+        for (chain = 0; chain < SERDES_MAX_CHAINS; chain++)
+        {
+            if (metrics_len[chain][family] == 0)
+                continue;
+            memcpy(p, metrics_text[chain][family], metrics_len[chain][family]);
+            p += metrics_len[chain][family];
+        }
+    }
+
+    pthread_mutex_unlock(&metrics_lock);
+
+    memcpy(p, METRICS_EOF, strlen(METRICS_EOF));
+    p += strlen(METRICS_EOF);
+
+    *plen = p - pbuf;
+
+    return pbuf;
+}
+
+static void metrics_client_close(metrics_client *pclient)
+{
+    close(pclient->fd);
+    free(pclient->response);
+    memset(pclient, 0, sizeof(metrics_client));
+    pclient->fd = -1;
+}
+
+/**
+ * Request read so far: answer once the header is complete
+ * */
+static void metrics_client_request(metrics_client *pclient)
+{
+    ssize_t n;
+
+    n = recv(pclient->fd, pclient->request + pclient->request_len,
+            sizeof(pclient->request) - 1 - pclient->request_len, 0);
+    if (n <= 0)
+    {
+        if ((n < 0) && (errno == EAGAIN))
+            return;
+        metrics_client_close(pclient);
+        return;
+    }
+
+    pclient->request_len += n;
+    pclient->request[pclient->request_len] = '\0';
+
+    if ((strstr(pclient->request, "\r\n\r\n") == NULL) && (strstr(pclient->request, "\n\n") == NULL))
+    {
+        /* Header too long */
+        if (pclient->request_len == sizeof(pclient->request) - 1)
+            metrics_client_close(pclient);
+        return;
+    }
+
+    if ((strncmp(pclient->request, "GET /metrics ", 13) == 0) ||
+        (strncmp(pclient->request, "GET / ", 6) == 0))
+    {
+        pclient->response = metrics_render(&pclient->response_len);
+    } else {
+        pclient->response = strdup(METRICS_NOT_FOUND);
+        pclient->response_len = strlen(METRICS_NOT_FOUND);
+    }
+
+    if (pclient->response == NULL)
+        metrics_client_close(pclient);
+}
+
+static void metrics_client_send(metrics_client *pclient)
+{
+    ssize_t n;
+
+    n = send(pclient->fd, pclient->response + pclient->sent,
+            pclient->response_len - pclient->sent, MSG_NOSIGNAL);
+    if (n < 0)
+    {
+        if (errno != EAGAIN)
+            metrics_client_close(pclient);
+        return;
+    }
+
+    pclient->sent += n;
+    if (pclient->sent == pclient->response_len)
+        metrics_client_close(pclient);
+}
+
+static void metrics_accept(void)
+{
+    int fd, i;
+
+    fd = accept(metrics_listen_fd, NULL, NULL);
+    if (fd < 0)
+        return;
+
+    for (i = 0; i < METRICS_MAX_CLIENTS; i++)
+    {
+        if (metrics_clients[i].fd < 0)
+            break;
+    }
+
+    /* Busy, the scraper retries */
+    if (i == METRICS_MAX_CLIENTS)
+    {
+        close(fd);
+        return;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    metrics_clients[i].fd = fd;
+}
+
+/**
+ * Serve scrapes until metrics_close(), apart from the monitor threads
+ * */
+static void *metrics_worker(void *arg)
+{
+    struct pollfd pfd[2 + METRICS_MAX_CLIENTS];
+    metrics_client *pclient;
+    int owner[2 + METRICS_MAX_CLIENTS];
+    int nfds, i;
+
+    (void)arg;
+
+    for (;;)
+    {
+        pfd[0].fd = metrics_stop_fd[0];
+        pfd[0].events = POLLIN;
+        pfd[1].fd = metrics_listen_fd;
+        pfd[1].events = POLLIN;
+        nfds = 2;
+
+        for (i = 0; i < METRICS_MAX_CLIENTS; i++)
+        {
+            if (metrics_clients[i].fd < 0)
+                continue;
+            pfd[nfds].fd = metrics_clients[i].fd;
+            pfd[nfds].events = (metrics_clients[i].response == NULL) ? POLLIN : POLLOUT;
+            owner[nfds++] = i;
+        }
+
+        if (poll(pfd, nfds, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        if (pfd[0].revents != 0)
+            break;
+
+        for (i = 2; i < nfds; i++)
+        {
+            pclient = &metrics_clients[owner[i]];
+            if (pfd[i].revents & (POLLERR | POLLNVAL))
+                metrics_client_close(pclient);
+            else if (pfd[i].revents & (POLLIN | POLLHUP))
+                metrics_client_request(pclient);
+            else if (pfd[i].revents & POLLOUT)
+                metrics_client_send(pclient);
+        }
+
+        if (pfd[1].revents & POLLIN)
+            metrics_accept();
+    }
+
+    return NULL;
+}
+
+/**
+ * Listen on 127.0.0.1:<port>, or on a Unix socket if the spec is a path
+ * */
+static int metrics_listen(const char *spec)
+{
+    struct sockaddr_in sin;
+    struct sockaddr_un sun;
+    char *pend;
+    unsigned long port;
+    int fd, one = 1, ret;
+
+    port = strtoul(spec, &pend, 10);
+
+    if ((*spec != '\0') && (*pend == '\0'))
+    {
+        if ((port == 0) || (port > 65535))
+        {
+            printf("Error: bad metrics port %s\r\n", spec);
+            return -EINVAL;
+        }
+
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return -errno;
+
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        memset(&sin, 0, sizeof(sin));
+        sin.sin_family = AF_INET;
+        sin.sin_port = htons(port);
+        sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ret = bind(fd, (struct sockaddr *)&sin, sizeof(sin));
+    } else {
+        if (strlen(spec) >= sizeof(sun.sun_path))
+        {
+            printf("Error: metrics socket path %s is too long\r\n", spec);
+            return -EINVAL;
+        }
+
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return -errno;
+
+        /* Left over from an earlier run */
+        unlink(spec);
+
+        memset(&sun, 0, sizeof(sun));
+        sun.sun_family = AF_UNIX;
+        strcpy(sun.sun_path, spec);
+        ret = bind(fd, (struct sockaddr *)&sun, sizeof(sun));
+        if (ret == 0)
+            metrics_unix_path = spec;
+    }
+
+    if ((ret < 0) || (listen(fd, METRICS_MAX_CLIENTS) < 0))
+    {
+        ret = -errno;
+        printf("Error: can't listen for metrics on %s: %s\r\n", spec, strerror(errno));
+        close(fd);
+        return ret;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    return fd;
+}
+
+int metrics_open(const char *spec)
+{
+    int i;
+
+    metrics_listen_fd = metrics_listen(spec);
+    if (metrics_listen_fd < 0)
+        return metrics_listen_fd;
+
+    for (i = 0; i < METRICS_MAX_CLIENTS; i++)
+        metrics_clients[i].fd = -1;
+
+    if ((pipe(metrics_stop_fd) < 0) ||
+        (pthread_create(&metrics_thread, NULL, metrics_worker, NULL) != 0))
+    {
+        printf("Error: can't start the metrics server\r\n");
+        close(metrics_listen_fd);
+        metrics_listen_fd = -1;
+        return -EFAULT;
+    }
+
+    printf("Serving OpenMetrics on %s\r\n", spec);
+
+    return 0;
+}
+
+void metrics_close(void)
+{
+    int chain, family, i;
+
+    if (metrics_listen_fd < 0)
+        return;
+
+    if (write(metrics_stop_fd[1], "", 1) == 1)
+        pthread_join(metrics_thread, NULL);
+
+    for (i = 0; i < METRICS_MAX_CLIENTS; i++)
+    {
+        if (metrics_clients[i].fd >= 0)
+            metrics_client_close(&metrics_clients[i]);
+    }
+
+    close(metrics_stop_fd[0]);
+    close(metrics_stop_fd[1]);
+    close(metrics_listen_fd);
+    metrics_listen_fd = -1;
+
+    if (metrics_unix_path != NULL)
+        unlink(metrics_unix_path);
+
+    for (chain = 0; chain < SERDES_MAX_CHAINS; chain++)
+    {
+        for (family = 0; family < METRICS_FAMILIES; family++)
+        {
+            free(metrics_text[chain][family]);
+            metrics_text[chain][family] = NULL;
+            metrics_len[chain][family] = 0;
+        }
+    }
+}
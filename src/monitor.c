@@ -0,0 +1,626 @@
+/**
+ * @file   monitor.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  Periodic sampling of the chip stats: flags and counters, each
+ *         register group at its own rate, counters extended to 64 bits.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "serdes_head.h"
+#include "gmsl_shm.h"
+
+#define MONITOR_MAX_PORTS       GMSL_SHM_MAX_PORTS
+#define MONITOR_MAX_COUNTERS    GMSL_SHM_MAX_COUNTERS
+#define MONITOR_MAX_CHIPS       (1 + DESERIALIZER_MAX_LINKS)
+
+#define DES_FLAG(name, field)   { (name), offsetof(deserializer_stats, field), 1, 0, 0 }
+#define SER_FLAG(name, field)   { (name), offsetof(serializer_stats, field), 1, 0, 0 }
+
+typedef struct monitor_counter_ {
+    uint64_t    total;      /* Counted since the first sample */
+    uint32_t    last;       /* Hardware value at the previous sample */
+    uint32_t    delta;
+} monitor_counter;
+
+/* Deserializer, or the serializer of a link */
+typedef struct monitor_chip_ {
+    char                        name[8];
+    int                         link;       /* -1 - deserializer */
+    const stats_counter_desc    *desc;
+    const stats_counter_desc    *flags;
+    int                         num_counters;
+    int                         num_flags;
+    int                         num_ports;
+    uint64_t                    sample_us;  /* Of the counters */
+    uint64_t                    period_us;  /* Between the last two counters samples */
+    uint64_t                    flags_us;
+    uint32_t                    flags_set[MONITOR_MAX_PORTS];
+    int                         flags_valid;
+    monitor_counter             counters[MONITOR_MAX_PORTS][MONITOR_MAX_COUNTERS];
+} monitor_chip;
+
+/* Register group and its sampling period */
+typedef struct monitor_group_ {
+    uint32_t    group;
+    unsigned int period_ms;
+    uint64_t    due_us;
+} monitor_group;
+
+/* Set flags are reported by name, non-zero is set. In the order of the
+ * GMSL_SHM_DES_* and GMSL_SHM_SER_* bits. */
+static const stats_counter_desc monitor_des_flags[] = {
+    DES_FLAG("error", global_status),
+    DES_FLAG("remote_err", remote_error_flag),
+    DES_FLAG("locked", video_pipeline_locked_flag),
+    DES_FLAG("thr_ok", sufficient_video_rx_thr_flag),
+    DES_FLAG("blk_len_err", video_rx_blk_len_err_flag),
+    DES_FLAG("seq_err", video_seq_error_flag),
+    DES_FLAG("overflow", video_rx_overflow_flag),
+    DES_FLAG("tun_overflow", video_rx_tun_overflow_flag),
+    DES_FLAG("lcrc_err", lcrc_error_flag),
+    DES_FLAG("tunnel", video_tunnel_flag),
+};
+
+static const stats_counter_desc monitor_ser_flags[] = {
+    SER_FLAG("error", global_status),
+    SER_FLAG("pclk_det", tx_pclk_det_flag),
+    SER_FLAG("pclk_drift", tx_pclk_drift_flag),
+    SER_FLAG("fifo_warn", tx_fifo_warn_flag),
+    SER_FLAG("fifo_overflow", tx_fifo_overflow_flag),
+    SER_FLAG("tun_overflow", is_tunnel_overflow),
+    SER_FLAG("tunnel", is_tunnel_mode),
+};
+
+static volatile sig_atomic_t monitor_stop = 0;
+
+static void monitor_signal(int sig)
+{
+    (void)sig;
+    monitor_stop = 1;
+}
+
+static void monitor_signals_init(void)
+{
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = monitor_signal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+}
+
+/**
+ * Wait for an absolute time. On the system clock an armed timerfd is
+ * polled, so a signal ends the wait at once; transports with their own
+ * clock sleep on it.
+ * */
+static void monitor_wait_until(pserdes_chain pchain, int tfd, uint64_t wake_us)
+{
+    struct itimerspec its;
+    struct pollfd pfd;
+    uint64_t expirations;
+
+    if ((tfd < 0) || (pchain->bus.tp->now_ns != NULL))
+    {
+        time_sleep_until_us(&pchain->bus, wake_us);
+        return;
+    }
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = wake_us / 1000000ULL;
+    its.it_value.tv_nsec = (wake_us % 1000000ULL) * 1000;
+
+    if (timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL) < 0)
+    {
+        time_sleep_until_us(&pchain->bus, wake_us);
+        return;
+    }
+
+    pfd.fd = tfd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    if (poll(&pfd, 1, -1) > 0)
+    {
+        if (read(tfd, &expirations, sizeof(expirations)) < 0)
+            return;
+    }
+}
+
+/**
+ * Count what the counter moved since the previous sample. A wrapping
+ * counter is taken to have wrapped at most once in between, which holds
+ * while the period is within its max_period_ms.
+ * */
+static void monitor_extend(monitor_counter *pcnt, const stats_counter_desc *pdesc,
+        uint32_t raw, int first)
+{
+    uint32_t mask = (pdesc->bits >= 32) ? 0xFFFFFFFFU : ((1U << pdesc->bits) - 1);
+
+    raw &= mask;
+
+    if (pdesc->flags & COUNTER_CLEARED)
+        pcnt->delta = raw;
+    else
+        pcnt->delta = (raw - pcnt->last) & mask;
+
+    pcnt->last = raw;
+
+    /* The first sample is the baseline only */
+    if (first)
+        pcnt->delta = 0;
+
+    pcnt->total += pcnt->delta;
+}
+
+static int monitor_stats_value(const char *pstats, size_t stride, int port,
+        const stats_counter_desc *pdesc)
+{
+    int value;
+
+    memcpy(&value, pstats + port * stride + pdesc->offset, sizeof(value));
+
+    return value;
+}
+
+/**
+ * Read the register groups of a chip. Returns the groups whose values
+ * are new to report: counters past the baseline, flags that changed.
+ * */
+static uint32_t monitor_sample(pserdes_chain pchain, monitor_chip *pchip, uint32_t groups, int first)
+{
+    const char *pstats;
+    size_t stride;
+    uint64_t now_us;
+    uint32_t set, report = 0;
+    int port, i;
+
+    if (pchip->link < 0)
+    {
+        pchip->desc = deserializer_sample_stats(pchain, groups, &pchip->num_counters, &pchip->num_ports);
+        pchip->flags = monitor_des_flags;
+        pchip->num_flags = ARRAY_SIZE(monitor_des_flags);
+        pstats = (const char *)pchain->deser_content.deser_stats;
+        stride = sizeof(deserializer_stats);
+    } else {
+        pchip->desc = serializer_sample_stats(pchain, pchip->link, groups,
+                &pchip->num_counters, &pchip->num_ports);
+        pchip->flags = monitor_ser_flags;
+        pchip->num_flags = ARRAY_SIZE(monitor_ser_flags);
+        pstats = (const char *)pchain->links[pchip->link].ser_content.ser_stats;
+        stride = sizeof(serializer_stats);
+    }
+
+    if (pchip->desc == NULL)
+        return 0;
+
+    if (pchip->num_ports > MONITOR_MAX_PORTS)
+        pchip->num_ports = MONITOR_MAX_PORTS;
+    if (pchip->num_counters > MONITOR_MAX_COUNTERS)
+        pchip->num_counters = MONITOR_MAX_COUNTERS;
+
+    if (groups & STATS_GROUP_FLAGS)
+    {
+        pchip->flags_us = time_monotonic_us(&pchain->bus);
+
+        for (port = 0; port < pchip->num_ports; port++)
+        {
+            set = 0;
+            for (i = 0; i < pchip->num_flags; i++)
+            {
+                if (monitor_stats_value(pstats, stride, port, &pchip->flags[i]) != 0)
+                    set |= (1U << i);
+            }
+
+            if ((pchip->flags_valid == 0) || (set != pchip->flags_set[port]))
+                report |= STATS_GROUP_FLAGS;
+            pchip->flags_set[port] = set;
+        }
+        pchip->flags_valid = 1;
+    }
+
+    if (groups & STATS_GROUP_COUNTERS)
+    {
+        now_us = time_monotonic_us(&pchain->bus);
+        pchip->period_us = (first == 0) ? now_us - pchip->sample_us : 0;
+        pchip->sample_us = now_us;
+
+        for (port = 0; port < pchip->num_ports; port++)
+        {
+            for (i = 0; i < pchip->num_counters; i++)
+            {
+                monitor_extend(&pchip->counters[port][i], &pchip->desc[i],
+                        (uint32_t)monitor_stats_value(pstats, stride, port, &pchip->desc[i]), first);
+            }
+        }
+
+        if (first == 0)
+            report |= STATS_GROUP_COUNTERS;
+    }
+
+    return report;
+}
+
+static int monitor_line_start(char *line, size_t size, pserdes_chain pchain,
+        monitor_chip *pchip, uint64_t now_us, int port)
+{
+    return snprintf(line, size, "%llu.%06llu i2c-%d %s:%d",
+            (unsigned long long)(now_us / 1000000ULL),
+            (unsigned long long)(now_us % 1000000ULL),
+            pchain->bus.bus_num, pchip->name, port);
+}
+
+/**
+ * Flags lines: the names of the flags set, per port
+ * */
+static void monitor_report_flags(pserdes_chain pchain, monitor_chip *pchip)
+{
+    char line[512];
+    uint64_t now_us = time_monotonic_us(&pchain->bus);
+    int port, i, len;
+
+    for (port = 0; port < pchip->num_ports; port++)
+    {
+        len = monitor_line_start(line, sizeof(line), pchain, pchip, now_us, port);
+        len += snprintf(line + len, sizeof(line) - len, " flags");
+
+        for (i = 0; (i < pchip->num_flags) && (len < (int)sizeof(line)); i++)
+        {
+            if (pchip->flags_set[port] & (1U << i))
+                len += snprintf(line + len, sizeof(line) - len, " %s", pchip->flags[i].name);
+        }
+
+        printf("%s\r\n", line);
+    }
+}
+
+/**
+ * Counters lines: total, delta and rate of each counter, per port
+ * */
+static void monitor_report_counters(pserdes_chain pchain, monitor_chip *pchip)
+{
+    char line[512];
+    uint64_t period_us = pchip->period_us;
+    monitor_counter *pcnt;
+    int port, i, len;
+
+    for (port = 0; port < pchip->num_ports; port++)
+    {
+        len = monitor_line_start(line, sizeof(line), pchain, pchip, pchip->sample_us, port);
+
+        for (i = 0; (i < pchip->num_counters) && (len < (int)sizeof(line)); i++)
+        {
+            pcnt = &pchip->counters[port][i];
+            len += snprintf(line + len, sizeof(line) - len, " %s %llu +%u %.1f/s",
+                    pchip->desc[i].name, (unsigned long long)pcnt->total, pcnt->delta,
+                    (period_us != 0) ? pcnt->delta * 1000000.0 / period_us : 0.0);
+        }
+
+        printf("%s\r\n", line);
+    }
+}
+
+/**
+ * Rate the link locked at, Gbps, 0 - down or not known
+ * */
+static int monitor_link_speed(pserdes_chain pchain, int link)
+{
+    if (pchain->links[link].speed != 0)
+        return pchain->links[link].speed;
+
+    return (pchain->num_links == 1) ? pchain->deser_content.link_speed : 0;
+}
+
+/**
+ * Copy the chips of the chain into its --shm slot
+ * */
+static void monitor_publish(pserdes_chain pchain, const monitor_chip *chips, int num_chips)
+{
+    gmsl_shm_chain *pshm;
+    gmsl_shm_chip *pout;
+    const monitor_chip *pchip;
+    const char *name;
+    int link, port, c, i;
+
+    pshm = shm_export_write_begin(pchain->index);
+    if (pshm == NULL)
+        return;
+
+    pshm->num_links = pchain->num_links;
+    for (link = 0; (link < pchain->num_links) && (link < GMSL_SHM_MAX_LINKS); link++)
+        pshm->link_speed[link] = monitor_link_speed(pchain, link);
+
+    for (c = 0; c < num_chips; c++)
+    {
+        pchip = &chips[c];
+        if (pchip->link < 0)
+        {
+            pout = &pshm->des;
+            name = deserializer_get_name(pchain);
+        } else {
+            pout = &pshm->ser[pchip->link];
+            name = serializer_get_name(pchain, pchip->link);
+        }
+
+        snprintf(pout->name, sizeof(pout->name), "%s", (name != NULL) ? name : "");
+        pout->num_ports = pchip->num_ports;
+        pout->num_counters = pchip->num_counters;
+        pout->flags_ns = pchip->flags_us * 1000;
+        pout->counters_ns = pchip->sample_us * 1000;
+        pout->period_ns = pchip->period_us * 1000;
+
+        for (i = 0; i < pchip->num_counters; i++)
+            snprintf(pout->counter_names[i], sizeof(pout->counter_names[i]), "%s", pchip->desc[i].name);
+
+        for (port = 0; port < pchip->num_ports; port++)
+        {
+            pout->ports[port].flags = pchip->flags_set[port];
+            for (i = 0; i < pchip->num_counters; i++)
+            {
+                pout->ports[port].counters[i] = pchip->counters[port][i].total;
+                pout->ports[port].deltas[i] = pchip->counters[port][i].delta;
+            }
+        }
+    }
+
+    shm_export_write_end(pshm);
+}
+
+/**
+ * One family of the OpenMetrics samples of the chain
+ * */
+static void monitor_render_family(pserdes_chain pchain, const monitor_chip *chips, int num_chips, int family)
+{
+    const monitor_chip *pchip;
+    const monitor_counter *pcnt;
+    const char *name;
+    char labels[128], *text = NULL;
+    size_t len = 0;
+    FILE *fp;
+    int link, port, c, i;
+
+    fp = open_memstream(&text, &len);
+    if (fp == NULL)
+        return;
+
+    if (family == METRICS_LINK_SPEED)
+    {
+        name = deserializer_get_name(pchain);
+        for (link = 0; link < pchain->num_links; link++)
+            fprintf(fp, "gmsl_link_speed_gbps{bus=\"%d\",chip=\"%s\",link=\"%c\"} %d\n",
+                    pchain->bus.bus_num, (name != NULL) ? name : "", 'A' + link,
+                    monitor_link_speed(pchain, link));
+    }
+
+    for (c = 0; (c < num_chips) && (family != METRICS_LINK_SPEED); c++)
+    {
+        pchip = &chips[c];
+        name = (pchip->link < 0) ? deserializer_get_name(pchain) : serializer_get_name(pchain, pchip->link);
+
+        for (port = 0; port < pchip->num_ports; port++)
+        {
+            snprintf(labels, sizeof(labels), "bus=\"%d\",chip=\"%s\",dev=\"%s\",port=\"%d\"",
+                    pchain->bus.bus_num, (name != NULL) ? name : "", pchip->name, port);
+
+            if (family == METRICS_FLAG)
+            {
+                for (i = 0; i < pchip->num_flags; i++)
+                    fprintf(fp, "gmsl_flag{%s,flag=\"%s\"} %d\n", labels, pchip->flags[i].name,
+                            (pchip->flags_set[port] & (1U << i)) ? 1 : 0);
+                continue;
+            }
+
+            for (i = 0; i < pchip->num_counters; i++)
+            {
+                pcnt = &pchip->counters[port][i];
+                if (family == METRICS_COUNTER)
+                    fprintf(fp, "gmsl_packets_total{%s,counter=\"%s\"} %llu\n", labels,
+                            pchip->desc[i].name, (unsigned long long)pcnt->total);
+                else
+                    fprintf(fp, "gmsl_packet_rate{%s,counter=\"%s\"} %.1f\n", labels, pchip->desc[i].name,
+                            (pchip->period_us != 0) ? pcnt->delta * 1000000.0 / pchip->period_us : 0.0);
+            }
+        }
+    }
+
+    fclose(fp);
+
+    metrics_update(pchain->index, family, text, len);
+}
+
+/**
+ * OpenMetrics samples of the chain for --metrics: only the families of
+ * the groups just sampled are rendered again, scrapes are served from
+ * the text
+ * */
+static void monitor_render_metrics(pserdes_chain pchain, const monitor_chip *chips, int num_chips,
+        uint32_t groups)
+{
+    if (app_params.metrics_spec == NULL)
+        return;
+
+    if (groups & STATS_GROUP_FLAGS)
+    {
+        monitor_render_family(pchain, chips, num_chips, METRICS_LINK_SPEED);
+        monitor_render_family(pchain, chips, num_chips, METRICS_FLAG);
+    }
+
+    if (groups & STATS_GROUP_COUNTERS)
+    {
+        monitor_render_family(pchain, chips, num_chips, METRICS_COUNTER);
+        monitor_render_family(pchain, chips, num_chips, METRICS_RATE);
+    }
+}
+
+/**
+ * Counters period of the chain: monitor_ms, cut down to the period the
+ * fastest wrapping counter of the chips allows
+ * */
+static unsigned int monitor_counters_period(const monitor_chip *chips, int num_chips)
+{
+    const stats_counter_desc *plimit = NULL;
+    int i, c;
+
+    for (c = 0; c < num_chips; c++)
+    {
+        for (i = 0; i < chips[c].num_counters; i++)
+        {
+            if ((chips[c].desc[i].max_period_ms != 0) &&
+                ((plimit == NULL) || (chips[c].desc[i].max_period_ms < plimit->max_period_ms)))
+                plimit = &chips[c].desc[i];
+        }
+    }
+
+    if ((plimit == NULL) || (app_params.monitor_ms <= plimit->max_period_ms))
+        return app_params.monitor_ms;
+
+    printf("Warning: %s counter wraps in %u ms, counters sampled every %u ms instead of %u ms\r\n",
+            plimit->name, plimit->max_period_ms, plimit->max_period_ms, app_params.monitor_ms);
+
+    return plimit->max_period_ms;
+}
+
+static uint64_t monitor_next_due(const monitor_group *groups, int num_groups)
+{
+    uint64_t next_us = UINT64_MAX;
+    int i;
+
+    for (i = 0; i < num_groups; i++)
+    {
+        if (groups[i].due_us < next_us)
+            next_us = groups[i].due_us;
+    }
+
+    return next_us;
+}
+
+/**
+ * Groups due at now_us, their deadlines moved on by whole periods
+ * */
+static uint32_t monitor_groups_due(monitor_group *groups, int num_groups, uint64_t now_us)
+{
+    uint32_t due = 0;
+    int i;
+
+    for (i = 0; i < num_groups; i++)
+    {
+        if (groups[i].due_us > now_us)
+            continue;
+
+        due |= groups[i].group;
+
+        /* Ticks missed while the bus was busy are skipped */
+        while (groups[i].due_us <= now_us)
+            groups[i].due_us += (uint64_t)groups[i].period_ms * 1000;
+    }
+
+    return due;
+}
+
+/**
+ * Sample the stats of the chain until monitor_samples counter samples
+ * are taken or SIGINT/SIGTERM: lock and error flags every
+ * monitor_flags_ms, reported when they change, counters every monitor_ms
+ * or faster if one of them would wrap twice in between. Each group runs
+ * on absolute deadlines so the periods do not drift with the bus time.
+ * */
+int monitor_run(pserdes_chain pchain)
+{
+    monitor_chip chips[MONITOR_MAX_CHIPS];
+    monitor_group groups[] = {
+        { STATS_GROUP_FLAGS,    app_params.monitor_flags_ms, 0 },
+        { STATS_GROUP_COUNTERS, app_params.monitor_ms,       0 },
+    };
+    uint64_t now_us;
+    uint32_t due, report;
+    unsigned int n = 0;
+    int num_chips = 0, tfd, link, i;
+
+    memset(chips, 0, sizeof(chips));
+
+    /* Serializers not looked for yet, as for --stats */
+    for (link = 0; link < pchain->num_links; link++)
+        serializer_search_chip(pchain, link);
+
+    chips[num_chips].link = -1;
+    snprintf(chips[num_chips].name, sizeof(chips[num_chips].name), "des");
+    num_chips++;
+
+    for (link = 0; link < pchain->num_links; link++)
+    {
+        if (pchain->links[link].found_inx_ser < 0)
+            continue;
+
+        chips[num_chips].link = link;
+        snprintf(chips[num_chips].name, sizeof(chips[num_chips].name), "ser%c", 'A' + link);
+        num_chips++;
+    }
+
+    monitor_signals_init();
+
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+
+    /* Counters baseline, flags as they are now */
+    for (i = 0; i < num_chips; i++)
+    {
+        if (monitor_sample(pchain, &chips[i], STATS_GROUP_ALL & ~STATS_GROUP_DUMP, 1) & STATS_GROUP_FLAGS)
+            monitor_report_flags(pchain, &chips[i]);
+    }
+
+    groups[1].period_ms = monitor_counters_period(chips, num_chips);
+
+    printf("Monitoring flags every %u ms, counters every %u ms, Ctrl+C to stop\r\n",
+            groups[0].period_ms, groups[1].period_ms);
+
+    monitor_publish(pchain, chips, num_chips);
+    monitor_render_metrics(pchain, chips, num_chips, STATS_GROUP_ALL);
+
+    now_us = time_monotonic_us(&pchain->bus);
+    for (i = 0; i < (int)ARRAY_SIZE(groups); i++)
+        groups[i].due_us = now_us + (uint64_t)groups[i].period_ms * 1000;
+
+    while ((app_params.monitor_samples == 0) || (n < app_params.monitor_samples))
+    {
+        monitor_wait_until(pchain, tfd, monitor_next_due(groups, ARRAY_SIZE(groups)));
+
+        if (monitor_stop)
+            break;
+
+        due = monitor_groups_due(groups, ARRAY_SIZE(groups), time_monotonic_us(&pchain->bus));
+        if (due == 0)
+            continue;
+
+        for (i = 0; i < num_chips; i++)
+        {
+            report = monitor_sample(pchain, &chips[i], due, 0);
+
+            if (report & STATS_GROUP_FLAGS)
+                monitor_report_flags(pchain, &chips[i]);
+            if (report & STATS_GROUP_COUNTERS)
+                monitor_report_counters(pchain, &chips[i]);
+        }
+
+        monitor_publish(pchain, chips, num_chips);
+        monitor_render_metrics(pchain, chips, num_chips, due);
+
+        if (due & STATS_GROUP_COUNTERS)
+            n++;
+    }
+
+    if (tfd >= 0)
+        close(tfd);
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file   profile.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  Bring-up phase profiler.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "serdes_head.h"
+
+static void profile_account_time(pi2c_bus pbus)
+{
+    profile_ctx *pprof = &pbus->profile;
+    uint64_t now_us = time_monotonic_us(pbus);
+
+    if (pprof->current >= 0)
+        pprof->phases[pprof->current].time_us += now_us - pprof->mark_us;
+
+    pprof->mark_us = now_us;
+}
+
+/**
+ * Switch to a phase, time and bus traffic are counted against it from now
+ * on. Time spent in a phase entered again adds up. NULL stops counting.
+ * Each bus keeps its own profile. Returns the name of the previous phase.
+ * */
+const char *profile_phase(pi2c_bus pbus, const char *name)
+{
+    profile_ctx *pprof = &pbus->profile;
+    const char *prev = (pprof->current >= 0) ? pprof->phases[pprof->current].name : NULL;
+    int i;
+
+    profile_account_time(pbus);
+
+    if (name == NULL)
+    {
+        pprof->current = -1;
+        return prev;
+    }
+
+    for (i = 0; i < pprof->num_phases; i++)
+    {
+        if (strcmp(pprof->phases[i].name, name) == 0)
+            break;
+    }
+
+    if (i == pprof->num_phases)
+    {
+        if (pprof->num_phases == PROFILE_MAX_PHASES)
+            return prev;
+
+        memset(&pprof->phases[i], 0, sizeof(pprof->phases[i]));
+        pprof->phases[i].name = name;
+        pprof->num_phases++;
+    }
+
+    pprof->current = i;
+
+    return prev;
+}
+
+void profile_count_i2c(pi2c_bus pbus, unsigned int reads, unsigned int writes, unsigned int bytes)
+{
+    profile_ctx *pprof = &pbus->profile;
+
+    if (pprof->current < 0)
+        return;
+
+    pprof->phases[pprof->current].xfers++;
+    pprof->phases[pprof->current].reads += reads;
+    pprof->phases[pprof->current].writes += writes;
+    pprof->phases[pprof->current].bytes += bytes;
+}
+
+void profile_count_sleep(pi2c_bus pbus, unsigned int delay_us)
+{
+    profile_ctx *pprof = &pbus->profile;
+
+    if (pprof->current < 0)
+        return;
+
+    pprof->phases[pprof->current].sleep_us += delay_us;
+}
+
+void profile_report(pi2c_bus pbus)
+{
+    profile_ctx *pprof = &pbus->profile;
+    profile_phase_t *profile_phases = pprof->phases;
+    int profile_num_phases = pprof->num_phases;
+    profile_phase_t total;
+    int i;
+
+    if (app_params.profile == 0)
+        return;
+
+    profile_phase(pbus, NULL);
+
+    memset(&total, 0, sizeof(total));
+    for (i = 0; i < profile_num_phases; i++)
+    {
+        total.time_us += profile_phases[i].time_us;
+        total.sleep_us += profile_phases[i].sleep_us;
+        total.xfers += profile_phases[i].xfers;
+        total.reads += profile_phases[i].reads;
+        total.writes += profile_phases[i].writes;
+        total.bytes += profile_phases[i].bytes;
+    }
+
+    if (app_params.profile == PROFILE_JSON)
+    {
+        printf("{\"phases\":[");
+        for (i = 0; i < profile_num_phases; i++)
+        {
+            printf("%s{\"name\":\"%s\",\"time_us\":%llu,\"sleep_us\":%llu,"
+                    "\"xfers\":%u,\"reads\":%u,\"writes\":%u,\"bytes\":%u}",
+                    (i == 0) ? "" : ",", profile_phases[i].name,
+                    (unsigned long long)profile_phases[i].time_us,
+                    (unsigned long long)profile_phases[i].sleep_us,
+                    profile_phases[i].xfers, profile_phases[i].reads,
+                    profile_phases[i].writes, profile_phases[i].bytes);
+        }
+        printf("],\"total_us\":%llu,\"sleep_us\":%llu,\"xfers\":%u,\"reads\":%u,"
+                "\"writes\":%u,\"bytes\":%u}\r\n",
+                (unsigned long long)total.time_us, (unsigned long long)total.sleep_us,
+                total.xfers, total.reads, total.writes, total.bytes);
+        return;
+    }
+
+    printf("======== Profile =========================\r\n");
+    printf("%-20s %9s %9s %6s %6s %6s %7s\r\n",
+            "Phase", "Time ms", "Sleep ms", "Xfers", "Reads", "Writes", "Bytes");
+
+    for (i = 0; i < profile_num_phases; i++)
+    {
+        printf("%-20s %9.3f %9.3f %6u %6u %6u %7u\r\n", profile_phases[i].name,
+                profile_phases[i].time_us / 1000.0, profile_phases[i].sleep_us / 1000.0,
+                profile_phases[i].xfers, profile_phases[i].reads,
+                profile_phases[i].writes, profile_phases[i].bytes);
+    }
+
+    printf("%-20s %9.3f %9.3f %6u %6u %6u %7u\r\n", "Total",
+            total.time_us / 1000.0, total.sleep_us / 1000.0,
+            total.xfers, total.reads, total.writes, total.bytes);
+}
@@ -0,0 +1,420 @@
+/**
+ * @file   regcache.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  Write-through shadow register cache.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "serdes_head.h"
+
+#define REGCACHE_IS_VALID(c, r)   ((c)->valid[(r) >> 3] & (1 << ((r) & 7)))
+#define REGCACHE_SET_VALID(c, r)  ((c)->valid[(r) >> 3] |= (1 << ((r) & 7)))
+
+/* Registers past 0xFFFF are not cached */
+#define REGCACHE_SPAN_OK(r, len)  ((size_t)(r) + (len) <= REGCACHE_SIZE)
+
+#define REGCACHE_PREFETCH_MAX         (256)
+#define REGCACHE_PREFETCH_MAX_BURSTS  (32)
+
+static const regcache_range *regcache_range_of(pregcache pcache, unsigned short reg_addr)
+{
+    int i;
+
+    for (i = 0; i < pcache->num_ranges; i++)
+    {
+        if ((reg_addr >= pcache->ranges[i].first) &&
+            (reg_addr <= pcache->ranges[i].last))
+        {
+            return &pcache->ranges[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Bits of the register which change without a write
+ * */
+static uint8_t regcache_sc_mask(pregcache pcache, unsigned short reg_addr)
+{
+    const regcache_range *prange = regcache_range_of(pcache, reg_addr);
+
+    return (prange != NULL) ? prange->sc_mask : 0;
+}
+
+/**
+ * A write setting reset bits leaves no register known
+ * */
+static int regcache_is_reset(pregcache pcache, unsigned short reg_addr, unsigned char value_byte)
+{
+    const regcache_range *prange = regcache_range_of(pcache, reg_addr);
+
+    return (prange != NULL) && (value_byte & prange->reset_mask);
+}
+
+/**
+ * Store a value known to be in the register
+ * */
+static void regcache_store(pregcache pcache, unsigned short reg_addr, unsigned char value_byte)
+{
+    uint8_t sc_mask = regcache_sc_mask(pcache, reg_addr);
+
+    if (sc_mask == REGCACHE_VOLATILE)
+        return;
+
+    /* Self-clearing bits read back as zero */
+    pcache->value[reg_addr] = value_byte & ~sc_mask;
+    REGCACHE_SET_VALID(pcache, reg_addr);
+}
+
+pregcache regcache_create(const regcache_range *ranges, int num_ranges)
+{
+    pregcache pcache;
+
+    pcache = calloc(1, sizeof(regcache));
+    if (pcache == NULL)
+        return NULL;
+
+    pcache->ranges = ranges;
+    pcache->num_ranges = num_ranges;
+
+    return pcache;
+}
+
+void regcache_destroy(pregcache pcache)
+{
+    free(pcache);
+}
+
+void regcache_invalidate(pregcache pcache)
+{
+    if (pcache == NULL)
+        return;
+
+    memset(pcache->valid, 0, sizeof(pcache->valid));
+}
+
+int regcache_read_reg8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr,
+        unsigned short reg_addr, unsigned char *buf)
+{
+    int ret = 0;
+
+    if (pcache == NULL)
+        return i2c_read_reg8a16(pbus, dev_addr, reg_addr, buf);
+
+    if (REGCACHE_IS_VALID(pcache, reg_addr))
+    {
+        *buf = pcache->value[reg_addr];
+        pcache->hits++;
+        return 0;
+    }
+
+    pcache->misses++;
+
+    ret = i2c_read_reg8a16(pbus, dev_addr, reg_addr, buf);
+    if (ret < 0)
+        return ret;
+
+    regcache_store(pcache, reg_addr, *buf);
+
+    return 0;
+}
+
+int regcache_read_burst8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr,
+        unsigned short reg_addr, unsigned char *buf, size_t length)
+{
+    int ret = 0;
+    size_t i;
+
+    if ((pcache == NULL) || !REGCACHE_SPAN_OK(reg_addr, length))
+        return i2c_read_burst8a16(pbus, dev_addr, reg_addr, buf, length);
+
+    for (i = 0; i < length; i++)
+    {
+        if (!REGCACHE_IS_VALID(pcache, reg_addr + i))
+            break;
+    }
+
+    if (i == length)
+    {
+        memcpy(buf, &pcache->value[reg_addr], length);
+        pcache->hits += length;
+        return 0;
+    }
+
+    pcache->misses += length;
+
+    ret = i2c_read_burst8a16(pbus, dev_addr, reg_addr, buf, length);
+    if (ret < 0)
+        return ret;
+
+    for (i = 0; i < length; i++)
+        regcache_store(pcache, reg_addr + i, buf[i]);
+
+    return 0;
+}
+
+int regcache_read_regs8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr,
+        const unsigned short *reg_addr, unsigned char *buf, int count)
+{
+    int ret = 0, i;
+
+    /* Misses are fetched together in one transfer */
+    i2c_batch_begin(pbus);
+
+    for (i = 0; i < count; i++)
+    {
+        if ((pcache != NULL) && REGCACHE_IS_VALID(pcache, reg_addr[i]))
+        {
+            buf[i] = pcache->value[reg_addr[i]];
+            pcache->hits++;
+            continue;
+        }
+
+        if (pcache != NULL)
+            pcache->misses++;
+
+        i2c_batch_read_reg8a16(pbus, dev_addr, reg_addr[i], &buf[i]);
+    }
+
+    ret = i2c_batch_flush(pbus);
+    i2c_batch_end(pbus);
+    if (ret < 0)
+        return ret;
+
+    if (pcache != NULL)
+    {
+        for (i = 0; i < count; i++)
+            regcache_store(pcache, reg_addr[i], buf[i]);
+    }
+
+    return 0;
+}
+
+/**
+ * Several bursts, buf holds them one after another. Bursts not fully
+ * cached are fetched together in one transfer.
+ * */
+int regcache_read_bursts8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr,
+        const unsigned short *reg_addr, const unsigned char *length, unsigned char *buf, int count)
+{
+    unsigned char *pbuf;
+    int ret = 0, i, k;
+
+    i2c_batch_begin(pbus);
+
+    for (i = 0, pbuf = buf; i < count; pbuf += length[i++])
+    {
+        if ((pcache != NULL) && REGCACHE_SPAN_OK(reg_addr[i], length[i]))
+        {
+            for (k = 0; k < length[i]; k++)
+            {
+                if (!REGCACHE_IS_VALID(pcache, reg_addr[i] + k))
+                    break;
+            }
+
+            if (k == length[i])
+            {
+                memcpy(pbuf, &pcache->value[reg_addr[i]], length[i]);
+                pcache->hits += length[i];
+                continue;
+            }
+
+            pcache->misses += length[i];
+        }
+
+        i2c_batch_read_burst8a16(pbus, dev_addr, reg_addr[i], pbuf, length[i]);
+    }
+
+    ret = i2c_batch_flush(pbus);
+    i2c_batch_end(pbus);
+    if (ret < 0)
+        return ret;
+
+    if (pcache != NULL)
+    {
+        for (i = 0, pbuf = buf; i < count; pbuf += length[i++])
+        {
+            if (!REGCACHE_SPAN_OK(reg_addr[i], length[i]))
+                continue;
+
+            for (k = 0; k < length[i]; k++)
+                regcache_store(pcache, reg_addr[i] + k, pbuf[k]);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Fetch the registers not known yet in as few bursts as they allow, so
+ * delta mode compares against the cache instead of reading one by one.
+ * Volatile registers are left out, reading them may have side effects.
+ * */
+int regcache_prefetch8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr,
+        const unsigned short *reg_addr, int count)
+{
+    unsigned short first[REGCACHE_PREFETCH_MAX_BURSTS];
+    unsigned char length[REGCACHE_PREFETCH_MAX_BURSTS];
+    unsigned char buf[REGCACHE_PREFETCH_MAX];
+    int num = 0, total = 0, i, k;
+
+    if (pcache == NULL)
+        return 0;
+
+    for (i = 0; (i < count) && (total < REGCACHE_PREFETCH_MAX); i++)
+    {
+        if (REGCACHE_IS_VALID(pcache, reg_addr[i]) ||
+            (regcache_sc_mask(pcache, reg_addr[i]) == REGCACHE_VOLATILE))
+        {
+            continue;
+        }
+
+        for (k = 0; k < num; k++)
+        {
+            if ((reg_addr[i] >= first[k]) && (reg_addr[i] < first[k] + length[k]))
+                break;
+        }
+        if (k < num)
+            continue;
+
+        if ((num > 0) && (reg_addr[i] == first[num - 1] + length[num - 1]) && (length[num - 1] < 0xFF))
+        {
+            length[num - 1]++;
+        } else {
+            if (num == REGCACHE_PREFETCH_MAX_BURSTS)
+                break;
+
+            first[num] = reg_addr[i];
+            length[num++] = 1;
+        }
+
+        total++;
+    }
+
+    if (num == 0)
+        return 0;
+
+    return regcache_read_bursts8a16(pbus, pcache, dev_addr, first, length, buf, num);
+}
+
+/**
+ * In delta mode tell whether the write would change the register,
+ * counting it as elided when it would not
+ * */
+int regcache_write_needed(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr,
+        unsigned short reg_addr, unsigned char value_byte)
+{
+    uint8_t sc_mask, reg8 = 0;
+
+    if ((pcache == NULL) || (pcache->delta == 0))
+        return 1;
+
+    sc_mask = regcache_sc_mask(pcache, reg_addr);
+
+    /* Writes setting self-clearing bits always have an effect */
+    if ((sc_mask != REGCACHE_VOLATILE) && ((value_byte & sc_mask) == 0) &&
+        (regcache_read_reg8a16(pbus, pcache, dev_addr, reg_addr, &reg8) == 0) &&
+        (reg8 == value_byte))
+    {
+        pcache->elided++;
+        return 0;
+    }
+
+    return 1;
+}
+
+int regcache_write_reg8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr,
+        unsigned short reg_addr, unsigned char value_byte)
+{
+    int ret = 0;
+
+    if (regcache_write_needed(pbus, pcache, dev_addr, reg_addr, value_byte) == 0)
+        return 0;
+
+    if (pcache != NULL)
+        pcache->writes++;
+
+    ret = i2c_write_reg8a16(pbus, dev_addr, reg_addr, value_byte);
+    if (ret < 0)
+    {
+        /* Unknown state now */
+        if (pcache != NULL)
+            pcache->valid[reg_addr >> 3] &= ~(1 << (reg_addr & 7));
+        return ret;
+    }
+
+    if (pcache == NULL)
+        return 0;
+
+    if (regcache_is_reset(pcache, reg_addr, value_byte))
+        regcache_invalidate(pcache);
+    else
+        regcache_store(pcache, reg_addr, value_byte);
+
+    return 0;
+}
+
+/**
+ * Write-through burst, no delta filtering (see regcache_write_needed)
+ * */
+int regcache_write_burst8a16(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr,
+        unsigned short reg_addr, const unsigned char *buf, size_t length)
+{
+    int ret = 0;
+    size_t i;
+
+    if (pcache != NULL)
+        pcache->writes += length;
+
+    ret = i2c_write_burst8a16(pbus, dev_addr, reg_addr, buf, length);
+
+    if (pcache == NULL)
+        return ret;
+
+    if (!REGCACHE_SPAN_OK(reg_addr, length))
+    {
+        regcache_invalidate(pcache);
+        return ret;
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        if ((ret >= 0) && regcache_is_reset(pcache, reg_addr + i, buf[i]))
+        {
+            regcache_invalidate(pcache);
+            break;
+        }
+
+        if (ret < 0)
+            pcache->valid[(reg_addr + i) >> 3] &= ~(1 << ((reg_addr + i) & 7));
+        else
+            regcache_store(pcache, reg_addr + i, buf[i]);
+    }
+
+    return ret;
+}
+
+/**
+ * In delta mode a settle delay is only needed when something was
+ * written since the previous one
+ * */
+int regcache_settle_needed(pregcache pcache)
+{
+    int ret = 1;
+
+    if ((pcache == NULL) || (pcache->delta == 0))
+        return 1;
+
+    if (pcache->writes == pcache->settle_mark)
+        ret = 0;
+
+    pcache->settle_mark = pcache->writes;
+
+    return ret;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file   regseq.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  Register sequence engine.
+ *
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include "serdes_head.h"
+
+#define REG_SEQ_MAX_BURST       (32)
+#define REG_SEQ_MAX_UPDATES     (16)
+#define REG_SEQ_MAX_PREFETCH    (128)
+
+#define REG_SEQ_IS_WRITE(e)     (((e)->poll == 0) && ((e)->mask == 0xFF))
+#define REG_SEQ_IS_UPDATE(e)    (((e)->poll == 0) && ((e)->mask != 0xFF) && ((e)->mask != 0))
+
+/**
+ * Wait until (reg & mask) == value, the register is always read from the chip
+ * */
+static int reg_seq_poll(pi2c_bus pbus, unsigned char dev_addr, const reg_seq_entry *pentry)
+{
+    i2c_batch_flush(pbus);
+
+    return poll_reg8a16(pbus, dev_addr, pentry->addr, pentry->mask, pentry->value,
+            (pentry->delay_us + 999) / 1000, NULL);
+}
+
+/**
+ * Plain writes: adjacent addresses are merged into auto-increment bursts,
+ * writes which would not change anything (delta mode) split the burst
+ * */
+static int reg_seq_write_run(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr,
+        const reg_seq_entry *seq, int count, int *consumed)
+{
+    uint8_t burst[REG_SEQ_MAX_BURST];
+    uint8_t needed[REG_SEQ_MAX_BURST];
+    int ret = 0, n = 1, k, m;
+
+    while ((n < count) && (n < REG_SEQ_MAX_BURST) &&
+           REG_SEQ_IS_WRITE(&seq[n]) &&
+           (seq[n - 1].delay_us == 0) &&
+           (seq[n].addr == seq[0].addr + n))
+    {
+        n++;
+    }
+
+    for (k = 0; k < n; k++)
+    {
+        needed[k] = regcache_write_needed(pbus, pcache, dev_addr, seq[k].addr, seq[k].value);
+        burst[k] = seq[k].value;
+    }
+
+    k = 0;
+    while ((k < n) && (ret == 0))
+    {
+        if (needed[k] == 0)
+        {
+            k++;
+            continue;
+        }
+
+        m = k;
+        while ((m < n) && (needed[m] != 0))
+            m++;
+
+        if (m - k == 1)
+            ret = regcache_write_reg8a16(pbus, pcache, dev_addr, seq[k].addr, seq[k].value);
+        else
+            ret = regcache_write_burst8a16(pbus, pcache, dev_addr, seq[k].addr, &burst[k], m - k);
+
+        k = m;
+    }
+
+    *consumed = n;
+
+    return ret;
+}
+
+/**
+ * Read-modify-writes: current values are fetched together, then written
+ * */
+static int reg_seq_update_run(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr,
+        const reg_seq_entry *seq, int count, int *consumed)
+{
+    uint16_t addr[REG_SEQ_MAX_UPDATES];
+    uint8_t value[REG_SEQ_MAX_UPDATES];
+    int ret = 0, n = 0, k;
+
+    while ((n < count) && (n < REG_SEQ_MAX_UPDATES) &&
+           REG_SEQ_IS_UPDATE(&seq[n]) &&
+           ((n == 0) || (seq[n - 1].delay_us == 0)))
+    {
+        /* A repeated register needs the result of the earlier update */
+        for (k = 0; k < n; k++)
+        {
+            if (addr[k] == seq[n].addr)
+                break;
+        }
+        if (k < n)
+            break;
+
+        addr[n] = seq[n].addr;
+        n++;
+    }
+
+    ret = regcache_read_regs8a16(pbus, pcache, dev_addr, addr, value, n);
+
+    for (k = 0; (k < n) && (ret == 0); k++)
+    {
+        value[k] = (value[k] & ~seq[k].mask) | (seq[k].value & seq[k].mask);
+        ret = regcache_write_reg8a16(pbus, pcache, dev_addr, addr[k], value[k]);
+    }
+
+    *consumed = n;
+
+    return ret;
+}
+
+/**
+ * Delta mode: what the sequence writes is fetched up front, the writes
+ * are then compared against the cache
+ * */
+static int reg_seq_prefetch(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr,
+        const reg_seq_entry *seq, int count)
+{
+    uint16_t addr[REG_SEQ_MAX_PREFETCH];
+    int n = 0, i;
+
+    for (i = 0; (i < count) && (n < REG_SEQ_MAX_PREFETCH); i++)
+    {
+        if (REG_SEQ_IS_WRITE(&seq[i]) || REG_SEQ_IS_UPDATE(&seq[i]))
+            addr[n++] = seq[i].addr;
+    }
+
+    return regcache_prefetch8a16(pbus, pcache, dev_addr, addr, n);
+}
+
+/**
+ * Run a register sequence. Everything between delays and polls goes out
+ * as one I2C_RDWR transaction.
+ * */
+int reg_seq_run(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, const reg_seq_entry *seq, int count)
+{
+    int ret = 0, end_ret = 0, i = 0, n = 0;
+
+    if ((pcache != NULL) && (pcache->delta != 0))
+        reg_seq_prefetch(pbus, pcache, dev_addr, seq, count);
+
+    i2c_batch_begin(pbus);
+
+    while ((i < count) && (ret == 0))
+    {
+        n = 1;
+
+        if (seq[i].poll != 0)
+            ret = reg_seq_poll(pbus, dev_addr, &seq[i]);
+        else if (seq[i].mask == 0xFF)
+            ret = reg_seq_write_run(pbus, pcache, dev_addr, &seq[i], count - i, &n);
+        else if (seq[i].mask != 0)
+            ret = reg_seq_update_run(pbus, pcache, dev_addr, &seq[i], count - i, &n);
+
+        i += n;
+
+        /* Runs end at the first entry with a delay */
+        if ((seq[i - 1].poll == 0) && (seq[i - 1].delay_us != 0))
+        {
+            i2c_batch_flush(pbus);
+
+            if (regcache_settle_needed(pcache))
+                time_sleep_us(pbus, seq[i - 1].delay_us);
+        }
+    }
+
+    end_ret = i2c_batch_end(pbus);
+
+    return (ret < 0) ? ret : end_ret;
+}
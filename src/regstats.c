@@ -0,0 +1,117 @@
+/**
+ * @file   regstats.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  Stats table engine.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include "serdes_head.h"
+
+#define REG_STATS_MAX_REGS      (64)
+#define REG_STATS_MAX_BURST     (32)
+
+static int reg_stats_addr_cmp(const void *a, const void *b)
+{
+    return *(const uint16_t *)a - *(const uint16_t *)b;
+}
+
+/**
+ * Index of the register in the sorted list
+ * */
+static int reg_stats_find(const uint16_t *addr, int num_regs, uint16_t reg_addr)
+{
+    const uint16_t *pfound;
+
+    pfound = bsearch(&reg_addr, addr, num_regs, sizeof(uint16_t), reg_stats_addr_cmp);
+
+    return (pfound != NULL) ? (int)(pfound - addr) : -1;
+}
+
+/**
+ * Read the registers of the entries in the groups asked for and decode
+ * them into the stats, port n at stats + n * stride.
+ *
+ * Registers are read once each, sorted by address, adjacent ones in one
+ * burst and all bursts in one transfer. Gaps are never read over: some
+ * of the registers in between clear on read.
+ * */
+int reg_stats_read(pi2c_bus pbus, pregcache pcache, unsigned char dev_addr, const reg_stats_entry *table, int count,
+        uint32_t groups, void *stats, size_t stride)
+{
+    uint16_t addr[REG_STATS_MAX_REGS];
+    uint16_t run_addr[REG_STATS_MAX_REGS];
+    uint8_t run_len[REG_STATS_MAX_REGS];
+    uint8_t value[REG_STATS_MAX_REGS];
+    const reg_stats_entry *pentry;
+    int num_regs = 0, num_runs = 0, ret = 0, i, k;
+    int field, *pfield;
+
+    for (i = 0; i < count; i++)
+    {
+        if ((table[i].group & groups) == 0)
+            continue;
+
+        if (num_regs == REG_STATS_MAX_REGS)
+            return -EINVAL;
+
+        addr[num_regs++] = table[i].addr;
+    }
+
+    if (num_regs == 0)
+        return 0;
+
+    qsort(addr, num_regs, sizeof(uint16_t), reg_stats_addr_cmp);
+
+    /* Each register once, runs of adjacent ones */
+    for (i = 0, k = 0; i < num_regs; i++)
+    {
+        if ((k > 0) && (addr[i] == addr[k - 1]))
+            continue;
+
+        if ((k > 0) && (addr[i] == addr[k - 1] + 1) && (run_len[num_runs - 1] < REG_STATS_MAX_BURST))
+        {
+            run_len[num_runs - 1]++;
+        } else {
+            run_addr[num_runs] = addr[i];
+            run_len[num_runs++] = 1;
+        }
+
+        addr[k++] = addr[i];
+    }
+    num_regs = k;
+
+    ret = regcache_read_bursts8a16(pbus, pcache, dev_addr, run_addr, run_len, value, num_runs);
+    if (ret < 0)
+        return ret;
+
+    /* In table order, STATS_REG_OR builds on the entries before */
+    for (i = 0; i < count; i++)
+    {
+        pentry = &table[i];
+        if ((pentry->group & groups) == 0)
+            continue;
+
+        field = (value[reg_stats_find(addr, num_regs, pentry->addr)] >> pentry->shift) & pentry->mask;
+
+        if (pentry->flags & STATS_REG_INVERT)
+            field = (field == 0);
+
+        if ((pentry->flags & STATS_REG_ERROR) && (field != 0))
+            field = -1;
+
+        pfield = (int *)((char *)stats + pentry->port * stride + pentry->offset);
+
+        if (pentry->flags & STATS_REG_OR)
+            *pfield |= field;
+        else
+            *pfield = field;
+    }
+
+    return 0;
+}
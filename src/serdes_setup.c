@@ -22,40 +22,40 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
-    i2c_init(app_params.i2c_port);
-
-    if (deserializer_init() < 0)
+    if ((app_params.topology_file != NULL) &&
+        (serdes_chain_load_topology(app_params.topology_file) < 0))
     {
-        printf("Error: Deserializer not found!\r\n");
-        ret = EXIT_FAILURE;
-        goto app_close_routine;
+        return EXIT_FAILURE;
     }
 
-    if (app_params.no_init == 0)
+    /* One log, one recorded clock */
+    if ((app_params.num_chains > 1) &&
+        ((app_params.record_file != NULL) || (app_params.replay_file != NULL)))
     {
-        if (deserializer_search_for_serializer() < 0)
-        {
-            printf("Error: Serializer not found!\r\n");
-            ret = EXIT_FAILURE;
-            goto app_close_routine;
-        }
+        printf("Error: record and replay work on a single bus\r\n");
+        return EXIT_FAILURE;
     }
 
-    serializer_search_chip();
+    trace_init();
 
-    if (app_params.stats_flags != 0)
+    if ((app_params.sim_spec != NULL) && (i2c_sim_setup(app_params.sim_spec) < 0))
     {
-        serializer_get_stat();
-        deserializer_get_stat();
-        goto app_close_routine;
+        return EXIT_FAILURE;
     }
 
-    serializer_init(deserializer_get_features());
+    if ((app_params.replay_file != NULL) && (i2c_replay_setup(app_params.replay_file) < 0))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if ((app_params.record_file != NULL) && (i2c_record_start(app_params.record_file) < 0))
+    {
+        return EXIT_FAILURE;
+    }
 
-    deserializer_start();
+    ret = serdes_chains_run();
 
-app_close_routine:
-    i2c_exit();
+    trace_dump();
 
     return ret;
 }
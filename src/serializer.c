@@ -17,14 +17,121 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
 #include "serdes_head.h"
 
+#define SER_COUNTER(name, field, bits, flags) \
+    { (name), offsetof(serializer_stats, field), (bits), (flags), COUNTER_MAX_PERIOD_MS(bits) }
+
+#define SER_STAT(addr, mask, shift, port, group, field, flags) \
+    { (addr), (mask), (shift), (port), (group), (flags), offsetof(serializer_stats, field) }
+#define SER_STAT_BIT(addr, bit, port, field) \
+    SER_STAT((addr), 0x01, (bit), (port), STATS_GROUP_FLAGS, field, 0)
+#define SER_STAT_CNT(addr, port, field) \
+    SER_STAT((addr), 0xFF, 0, (port), STATS_GROUP_COUNTERS, field, 0)
+
+/* VIDEO_TX2 of a pipe */
+#define SER_STAT_VIDEO_TX2(addr, port) \
+    SER_STAT_BIT((addr), 4, (port), tx_fifo_warn_flag), \
+    SER_STAT_BIT((addr), 5, (port), tx_fifo_overflow_flag), \
+    SER_STAT_BIT((addr), 6, (port), tx_pclk_drift_flag), \
+    SER_STAT_BIT((addr), 7, (port), tx_pclk_det_flag)
+
+/* Status, error and counter registers */
+static const regcache_range max96717_volatile_regs[] = {
+    { 0x0010, 0x0010, 0xA0, 0xA0 },   /* Reset one-shot, reset all */
+    { 0x0013, 0x0013, REGCACHE_VOLATILE },
+    { 0x0019, 0x001F, REGCACHE_VOLATILE },
+    { 0x0022, 0x0027, REGCACHE_VOLATILE },
+    { 0x0112, 0x0112, 0xF0 },   /* VIDEO_TX2 status flags */
+    { 0x033B, 0x0344, REGCACHE_VOLATILE },
+    { 0x0380, 0x0380, REGCACHE_VOLATILE },
+    { 0x038D, 0x0390, REGCACHE_VOLATILE },
+};
+
+static const regcache_range max9295d_volatile_regs[] = {
+    { 0x0010, 0x0010, 0xA0, 0xA0 },   /* Reset one-shot, reset all */
+    { 0x0013, 0x0013, REGCACHE_VOLATILE },
+    { 0x0019, 0x001F, REGCACHE_VOLATILE },
+    { 0x0022, 0x0027, REGCACHE_VOLATILE },
+    { 0x0102, 0x0102, 0xF0 },   /* VIDEO_TX2 status flags X~U */
+    { 0x010A, 0x010A, 0xF0 },
+    { 0x0112, 0x0112, 0xF0 },
+    { 0x011A, 0x011A, 0xF0 },
+    { 0x0339, 0x0344, REGCACHE_VOLATILE },
+};
+
+/* Stats registers, per RX port */
+static const reg_stats_entry max96717_stats[] = {
+    SER_STAT(0x0013, 0x01, 2, 0, STATS_GROUP_FLAGS, global_status, STATS_REG_ERROR),    /* CTRL3: ERROR */
+    SER_STAT_BIT(0x0383, 7, 0, is_tunnel_mode),
+    SER_STAT_BIT(0x0380, 0, 0, is_tunnel_overflow),
+    SER_STAT_VIDEO_TX2(0x0112, 0),
+    /* MIPI RX PHY errors */
+    SER_STAT_CNT(0x033B, 0, mipi_rx_l_lp_errors),
+    SER_STAT_CNT(0x033C, 0, mipi_rx_l_hs_errors),
+    SER_STAT_CNT(0x033D, 0, mipi_rx_h_lp_errors),
+    SER_STAT_CNT(0x033E, 0, mipi_rx_h_hs_errors),
+    /* CSI controller errors */
+    SER_STAT_CNT(0x0343, 0, ctrl1_csi_l_errors),
+    SER_STAT_CNT(0x0344, 0, ctrl1_csi_h_errors),
+    /* DPHY, CSI, tunnel and clock counters */
+    SER_STAT_CNT(0x038D, 0, mipi_dphy_rx_count),
+    SER_STAT_CNT(0x038E, 0, mipi_pkt_processed),
+    SER_STAT_CNT(0x038F, 0, tunnel_pkt_processed),
+    SER_STAT_CNT(0x0390, 0, mipi_clk_rx_count),
+    SER_STAT_CNT(0x0025, 0, global_pkt_count),
+};
+
+static const reg_stats_entry max9295d_stats[] = {
+    SER_STAT(0x0013, 0x01, 2, 0, STATS_GROUP_FLAGS, global_status, STATS_REG_ERROR),    /* CTRL3: ERROR */
+    SER_STAT(0x0013, 0x01, 2, 1, STATS_GROUP_FLAGS, global_status, STATS_REG_ERROR),
+    /* Pipes X, Y, Z, U */
+    SER_STAT_VIDEO_TX2(0x0102, 0),
+    SER_STAT_VIDEO_TX2(0x010A, 1),
+    SER_STAT_VIDEO_TX2(0x0112, 2),
+    SER_STAT_VIDEO_TX2(0x011A, 3),
+    /* MIPI RX PHY and CSI controller errors of both ports */
+    SER_STAT_CNT(0x0339, 0, mipi_rx_l_lp_errors),
+    SER_STAT_CNT(0x033A, 0, mipi_rx_l_hs_errors),
+    SER_STAT_CNT(0x033B, 0, mipi_rx_h_lp_errors),
+    SER_STAT_CNT(0x033C, 0, mipi_rx_h_hs_errors),
+    SER_STAT_CNT(0x033D, 1, mipi_rx_l_lp_errors),
+    SER_STAT_CNT(0x033E, 1, mipi_rx_l_hs_errors),
+    SER_STAT_CNT(0x033F, 1, mipi_rx_h_lp_errors),
+    SER_STAT_CNT(0x0340, 1, mipi_rx_h_hs_errors),
+    SER_STAT_CNT(0x0341, 0, ctrl1_csi_l_errors),
+    SER_STAT_CNT(0x0342, 0, ctrl1_csi_h_errors),
+    SER_STAT_CNT(0x0343, 1, ctrl1_csi_l_errors),
+    SER_STAT_CNT(0x0344, 1, ctrl1_csi_h_errors),
+    SER_STAT_CNT(0x0025, 0, global_pkt_count),
+};
+
+/* Packet counters, per RX port */
+static const stats_counter_desc max96717_counters[] = {
+    SER_COUNTER("pkt", global_pkt_count, 8, COUNTER_CLEARED),   /* 0x0025, written 0 after reading */
+    SER_COUNTER("dphy", mipi_dphy_rx_count, 8, 0),          /* 0x038D */
+    SER_COUNTER("csi", mipi_pkt_processed, 8, 0),           /* 0x038E */
+    SER_COUNTER("clk", mipi_clk_rx_count, 8, 0),            /* 0x0390 */
+};
+
+/* No per-port MIPI counters */
+static const stats_counter_desc max9295d_counters[] = {
+    SER_COUNTER("pkt", global_pkt_count, 8, COUNTER_CLEARED),   /* 0x0025, written 0 after reading */
+};
+
 const serializer_entry serializers[] = {
   /* MAX96717 */
   {
     .ser_devid             = 0xBF,
     .ser_name              = "MAX96717",
     .rx_ports              = 1,
+    .volatile_regs         = max96717_volatile_regs,
+    .num_volatile_regs     = ARRAY_SIZE(max96717_volatile_regs),
+    .stats                 = max96717_stats,
+    .num_stats             = ARRAY_SIZE(max96717_stats),
+    .counters              = max96717_counters,
+    .num_counters          = ARRAY_SIZE(max96717_counters),
     .init                  = max96717_init,
     .start                 = max96717_start,
     .set_mipi_rx_params    = max96717_set_mipi_rx_params,
@@ -38,6 +145,12 @@ const serializer_entry serializers[] = {
     .ser_devid             = 0x95,
     .ser_name              = "MAX9295D",
     .rx_ports              = 2,
+    .volatile_regs         = max9295d_volatile_regs,
+    .num_volatile_regs     = ARRAY_SIZE(max9295d_volatile_regs),
+    .stats                 = max9295d_stats,
+    .num_stats             = ARRAY_SIZE(max9295d_stats),
+    .counters              = max9295d_counters,
+    .num_counters          = ARRAY_SIZE(max9295d_counters),
     .init                  = max9295d_init,
     .start                 = max9295d_start,
     .set_mipi_rx_params    = max9295d_set_mipi_rx_params,
@@ -51,6 +164,12 @@ const serializer_entry serializers[] = {
     .ser_devid             = 0xB7,
     .ser_name              = "MAX96793",
     .rx_ports              = 1,
+    .volatile_regs         = max96717_volatile_regs,
+    .num_volatile_regs     = ARRAY_SIZE(max96717_volatile_regs),
+    .stats                 = max96717_stats,
+    .num_stats             = ARRAY_SIZE(max96717_stats),
+    .counters              = max96717_counters,
+    .num_counters          = ARRAY_SIZE(max96717_counters),
     .init                  = max96793_init,
     .start                 = max96793_start,
     .set_mipi_rx_params    = max96793_set_mipi_rx_params,
@@ -66,38 +185,154 @@ const uint8_t serializer_default_i2c_slave[] =
   0x42U, 0x40U
 };
 
-/* Variables */
-static serializer_ctx ser_content;
-static int found_inx_ser = -1;
+/* State of a rate negotiation run */
+typedef struct serializer_neg_arg_ {
+    pserdes_chain   pchain;
+    int             link;
+    unsigned int    writes_mark;
+} serializer_neg_arg;
+
+int serializer_read_reg(pserializer_ctx pctx, uint16_t reg_addr, uint8_t *buf)
+{
+    return regcache_read_reg8a16(pctx->bus, pctx->regcache, pctx->i2c_slave_address, reg_addr, buf);
+}
+
+int serializer_read_burst(pserializer_ctx pctx, uint16_t reg_addr, uint8_t *buf, size_t length)
+{
+    return regcache_read_burst8a16(pctx->bus, pctx->regcache, pctx->i2c_slave_address, reg_addr, buf, length);
+}
+
+int serializer_write_reg(pserializer_ctx pctx, uint16_t reg_addr, uint8_t value)
+{
+    return regcache_write_reg8a16(pctx->bus, pctx->regcache, pctx->i2c_slave_address, reg_addr, value);
+}
+
+void serializer_settle(pserializer_ctx pctx, unsigned int delay_us)
+{
+    if (regcache_settle_needed(pctx->regcache))
+        time_sleep_us(pctx->bus, delay_us);
+}
+
+/**
+ * Settle delay cut short by a status register: returns as soon as
+ * (reg & mask) == value, delay_us bounds the wait. Zero mask - plain delay.
+ * */
+void serializer_settle_ready(pserializer_ctx pctx, uint16_t reg_addr, uint8_t mask, uint8_t value,
+        unsigned int delay_us)
+{
+    if (regcache_settle_needed(pctx->regcache) == 0)
+        return;
+
+    if (mask == 0)
+    {
+        time_sleep_us(pctx->bus, delay_us);
+        return;
+    }
+
+    poll_reg8a16(pctx->bus, pctx->i2c_slave_address, reg_addr, mask, value, (delay_us + 999) / 1000, NULL);
+}
+
+int serializer_poll_reg(pserializer_ctx pctx, uint16_t reg_addr, uint8_t mask, uint8_t value,
+        unsigned int timeout_ms, unsigned int *elapsed_ms)
+{
+    return poll_reg8a16(pctx->bus, pctx->i2c_slave_address, reg_addr, mask, value, timeout_ms, elapsed_ms);
+}
+
+int serializer_run_seq(pserializer_ctx pctx, const reg_seq_entry *seq, int count)
+{
+    return reg_seq_run(pctx->bus, pctx->regcache, pctx->i2c_slave_address, seq, count);
+}
+
+/**
+ * Read the stats table of the chip for the groups
+ * */
+int serializer_read_stats(pserializer_ctx pctx, uint32_t groups)
+{
+    return reg_stats_read(pctx->bus, pctx->regcache, pctx->i2c_slave_address, pctx->stats, pctx->num_stats,
+            groups, pctx->ser_stats, sizeof(serializer_stats));
+}
+
+/**
+ * Give the serializer of a link an address of its own, and the sensor
+ * behind it one too if --sensor is set. Only this link must be reachable.
+ * */
+static int serializer_move_address(pserdes_chain pchain, int link)
+{
+    pserializer_ctx pctx = &pchain->links[link].ser_content;
+    uint8_t sa_new = SERIALIZER_LINK_I2C_SA + link, reg8 = 0;
+
+    if (pctx->i2c_slave_address != sa_new)
+    {
+        /* REG0: DEV_ADDR at bits 7:1, answers on the new address at once */
+        if (i2c_write_reg8a16(&pchain->bus, pctx->i2c_slave_address, 0x0000, sa_new << 1) < 0)
+            return -1;
+
+        /* REG0 was written around the cache */
+        regcache_invalidate(pctx->regcache);
+
+        if (i2c_read_reg8a16(&pchain->bus, sa_new, 0x000D, &reg8) < 0)
+            return -1;
+
+        pctx->i2c_slave_address = sa_new;
+    }
+
+    if (app_params.sensor_i2c_sa != 0)
+    {
+        /* SRC_A: address on this bus, DST_A: sensor address behind the serializer */
+        serializer_write_reg(pctx, 0x0042, (SENSOR_LINK_I2C_SA + link) << 1);
+        serializer_write_reg(pctx, 0x0043, app_params.sensor_i2c_sa << 1);
+
+        printf("Link %c: serializer at 0x%02X, sensor at 0x%02X\r\n", 'A' + link,
+                sa_new, SENSOR_LINK_I2C_SA + link);
+    } else {
+        printf("Link %c: serializer at 0x%02X\r\n", 'A' + link, sa_new);
+    }
+
+    return 0;
+}
 
-int serializer_search_chip(void)
+/**
+ * Find the serializer behind a link, link 0 on single-link deserializers.
+ * On multi-link ones the search runs with only that link reachable and
+ * the serializer is moved to an address of its own, so all links are
+ * enabled again afterwards.
+ * */
+int serializer_search_chip(pserdes_chain pchain, int link)
 {
+    pserdes_link plink = &pchain->links[link];
     uint8_t reg8 = 0, sa_ser = 0;
     int i;
 
-    if (found_inx_ser >= 0) return 0;
+    if (plink->found_inx_ser >= 0) return 0;
+
+    if (pchain->num_links > 1)
+        deserializer_select_link(pchain, link);
 
-    if (app_params.ser_i2c_sa == 0)
+    if (pchain->ser_i2c_sa == 0)
     {
-        for (i = 0; i < ARRAY_SIZE(serializer_default_i2c_slave); i++)
+        /* Multi-link: moved to its own address by an earlier run */
+        for (i = (pchain->num_links > 1) ? -1 : 0; i < (int)ARRAY_SIZE(serializer_default_i2c_slave); i++)
         {
-            sa_ser = serializer_default_i2c_slave[i];
+            sa_ser = (i < 0) ? SERIALIZER_LINK_I2C_SA + link : serializer_default_i2c_slave[i];
 
-            if (i2c_read_reg8a16(sa_ser, 0x000D, &reg8) == 0)
+            if (i2c_read_reg8a16(&pchain->bus, sa_ser, 0x000D, &reg8) == 0)
             {
-                ser_content.i2c_slave_address = sa_ser;
+                plink->ser_content.i2c_slave_address = sa_ser;
                 break;
             }
         }
     } else {
-        sa_ser = app_params.ser_i2c_sa;
-
-        if (i2c_read_reg8a16(sa_ser, 0x000D, &reg8) < 0)
+        /* Multi-link: the configured address, then the one of an earlier run */
+        for (i = 0; i < ((pchain->num_links > 1) ? 2 : 1); i++)
         {
-            goto serializer_search_chip_end;
-        }
+            sa_ser = (i == 0) ? pchain->ser_i2c_sa : SERIALIZER_LINK_I2C_SA + link;
 
-        ser_content.i2c_slave_address = sa_ser;
+            if (i2c_read_reg8a16(&pchain->bus, sa_ser, 0x000D, &reg8) == 0)
+            {
+                plink->ser_content.i2c_slave_address = sa_ser;
+                break;
+            }
+        }
     }
 
     for (i = 0; i < ARRAY_SIZE(serializers); i++)
@@ -105,160 +340,296 @@ int serializer_search_chip(void)
         if (reg8 == serializers[i].ser_devid)
         {
             /* Found */
-            found_inx_ser = i;
+            plink->found_inx_ser = i;
+            plink->ser_content.stats = serializers[i].stats;
+            plink->ser_content.num_stats = serializers[i].num_stats;
+
+            if ((app_params.reg_cache != 0) || (app_params.delta_mode != 0))
+            {
+                plink->ser_content.regcache = regcache_create(serializers[i].volatile_regs,
+                        serializers[i].num_volatile_regs);
+                if (plink->ser_content.regcache != NULL)
+                    plink->ser_content.regcache->delta = app_params.delta_mode;
+            }
             break;
         }
     }
 
-serializer_search_chip_end:
-    return (found_inx_ser >= 0) ? 0 : -1;
+    if (pchain->num_links > 1)
+    {
+        if ((plink->found_inx_ser >= 0) && (serializer_move_address(pchain, link) < 0))
+        {
+            printf("Link %c: can't move serializer from 0x%02X\r\n", 'A' + link, sa_ser);
+            plink->found_inx_ser = -1;
+            regcache_destroy(plink->ser_content.regcache);
+            plink->ser_content.regcache = NULL;
+        }
+
+        deserializer_select_link(pchain, -1);
+    }
+
+    return (plink->found_inx_ser >= 0) ? 0 : -1;
 }
 
-int serializer_init(uint32_t features)
+static int serializer_try_speed(void *arg, int speed)
 {
-    int ret = 0, selected_speed = 0;
+    serializer_neg_arg *pneg = (serializer_neg_arg *)arg;
+    pserdes_chain pchain = pneg->pchain;
+    pserdes_link plink = &pchain->links[pneg->link];
+    int ret = 0;
 
-    serializer_search_chip();
+    /* Deserializer rate changes touch this link only */
+    if (pchain->num_links > 1)
+        pchain->deser_content.link_mask = 1 << pneg->link;
 
-    if (found_inx_ser < 0) return -1;
+    ret = serializers[plink->found_inx_ser].set_link_speed_gbps(&plink->ser_content, speed);
+    if (ret < 0)
+        return ret;
+
+    /* Re-applied config with the link already up at this rate */
+    if ((plink->ser_content.regcache != NULL) && (plink->ser_content.regcache->delta != 0) &&
+        (plink->ser_content.regcache->writes == pneg->writes_mark) &&
+        (deserializer_link_locked(pchain) > 0))
+    {
+        return serializers[plink->found_inx_ser].wait_for_link(&plink->ser_content);
+    }
 
-    ret = serializers[found_inx_ser].init(&ser_content);
+    ret = serializers[plink->found_inx_ser].reset_link(&plink->ser_content);
     if (ret < 0)
         return ret;
 
-    ret = serializers[found_inx_ser].set_mipi_rx_params(
-            &ser_content, 0,
-            app_params.mipi_rx_lanes,
-            app_params.mipi_rx_map,
-            app_params.mipi_rx_pol,
-            app_params.mipi_rx_skew_en, 1);
+    ret = deserializer_set_link_speed(pchain, speed);
+    if (ret >= 0)
+        ret = serializers[plink->found_inx_ser].wait_for_link(&plink->ser_content);
+
+    if (ret < 0)
+    {
+        /* Serializer is out of reach now, find it before the next rate */
+        deserializer_negotiate_link(pchain, pneg->link, speed);
+    }
+
+    return ret;
+}
+
+int serializer_init(pserdes_chain pchain, int link, uint32_t features)
+{
+    pserdes_link plink = &pchain->links[link];
+    int ret = 0, selected_speed = 0, port;
+    serializer_neg_arg neg;
+    uint8_t deser_addr;
+    const char *prev_phase;
+
+    serializer_search_chip(pchain, link);
+
+    if (plink->found_inx_ser < 0) return -1;
+
+    neg.pchain = pchain;
+    neg.link = link;
+    neg.writes_mark = 0;
+    if (plink->ser_content.regcache != NULL)
+        neg.writes_mark = plink->ser_content.regcache->writes;
+
+    ret = serializers[plink->found_inx_ser].init(&plink->ser_content);
     if (ret < 0)
         return ret;
 
-    if (features & FEATURE_DES_12GBPS)
+    prev_phase = profile_phase(&pchain->bus, "mipi_setup");
+
+    for (port = 0; (port < app_params.mipi_rx_ports) &&
+         (port < serializers[plink->found_inx_ser].rx_ports); port++)
     {
-        ret = serializers[found_inx_ser].set_link_speed_gbps(&ser_content, 12);
-        if (ret < 0)
-        {
-            if (features & FEATURE_DES_6GBPS)
-            {
-                ret = serializers[found_inx_ser].set_link_speed_gbps(&ser_content, 6);
-                if (ret < 0)
-                {
-                    ret = serializers[found_inx_ser].set_link_speed_gbps(&ser_content, 3);
-                    if (ret < 0)
-                        return ret;
-                    selected_speed = 3;
-                } else selected_speed = 6;
-            } else {
-                ret = serializers[found_inx_ser].set_link_speed_gbps(&ser_content, 3);
-                if (ret < 0)
-                    return ret;
-                selected_speed = 3;
-            }
-        } else selected_speed = 12;
-    } else if (features & FEATURE_DES_6GBPS) {
-        ret = serializers[found_inx_ser].set_link_speed_gbps(&ser_content, 6);
-        if (ret < 0)
-        {
-            ret = serializers[found_inx_ser].set_link_speed_gbps(&ser_content, 3);
-            if (ret < 0)
-                return ret;
-            selected_speed = 3;
-        } else selected_speed = 6;
-    } else {
-        ret = serializers[found_inx_ser].set_link_speed_gbps(&ser_content, 3);
+        ret = serializers[plink->found_inx_ser].set_mipi_rx_params(
+                &plink->ser_content, port,
+                app_params.mipi_rx_lanes[port],
+                app_params.mipi_rx_map[port],
+                app_params.mipi_rx_pol[port],
+                app_params.mipi_rx_skew_en, 1);
         if (ret < 0)
             return ret;
-        selected_speed = 3;
     }
 
-    ret = serializers[found_inx_ser].reset_link(&ser_content);
-    if (ret < 0)
-        return ret;
+    profile_phase(&pchain->bus, prev_phase);
 
-    ret = deserializer_set_link_speed(selected_speed);
-    if (ret < 0)
-        return ret;
+    deser_addr = deserializer_get_i2c_address(pchain);
 
-    ret = serializers[found_inx_ser].wait_for_link(&ser_content);
-    if (ret < 0)
-        return ret;
+    /* Rate the link already locked at, if known */
+    selected_speed = plink->speed;
+    if (selected_speed == 0)
+        selected_speed = link_state_load(pchain->bus.bus_num, deser_addr,
+                serializers[plink->found_inx_ser].ser_devid);
 
-    ret = serializers[found_inx_ser].start(&ser_content);
+    selected_speed = link_neg_run(features, &selected_speed, 1,
+            serializer_try_speed, &neg);
+    pchain->deser_content.link_mask = 0;
+    if (selected_speed < 0)
+        return selected_speed;
+
+    plink->speed = selected_speed;
+
+    link_state_save(pchain->bus.bus_num, deser_addr,
+            serializers[plink->found_inx_ser].ser_devid, selected_speed);
+
+    ret = serializers[plink->found_inx_ser].start(&plink->ser_content);
     if (ret < 0)
         return ret;
 
-    if (ret == 0)
+    if ((ret == 0) && (pchain->num_links > 1))
     {
-        printf("Found serializer %s\r\n", serializers[found_inx_ser].ser_name);
+        printf("Found serializer %s on link %c, link %dG locked in %u ms\r\n",
+                serializers[plink->found_inx_ser].ser_name, 'A' + link, selected_speed,
+                plink->ser_content.link_lock_ms);
+    } else if (ret == 0) {
+        printf("Found serializer %s, link %dG locked in %u ms\r\n",
+                serializers[plink->found_inx_ser].ser_name, selected_speed, plink->ser_content.link_lock_ms);
     }
 
     return ret;
 }
 
-int serializer_get_stat(void)
+/**
+ * Driver hook when the chip needs more than its stats table
+ * */
+static int serializer_update_stats(pserdes_chain pchain, int link, uint32_t groups)
+{
+    pserdes_link plink = &pchain->links[link];
+    const serializer_entry *pentry = &serializers[plink->found_inx_ser];
+
+    if (pentry->get_stats != NULL)
+        return pentry->get_stats(&plink->ser_content, groups);
+
+    return serializer_read_stats(&plink->ser_content, groups);
+}
+
+int serializer_get_stat(pserdes_chain pchain, int link)
 {
+    pserdes_link plink = &pchain->links[link];
     int i;
 
-    serializers[found_inx_ser].get_stats(&ser_content);
+    if (serializer_search_chip(pchain, link) < 0) return -1;
 
-    printf("======== Statistics [Ser] ================\r\n");
+    serializer_update_stats(pchain, link, STATS_GROUP_ALL);
 
-    for (i = 0; i < serializers[found_inx_ser].rx_ports; i++)
+    if (pchain->num_links > 1)
+        printf("======== Statistics [Ser %c] ==============\r\n", 'A' + link);
+    else
+        printf("======== Statistics [Ser] ================\r\n");
+
+    for (i = 0; i < serializers[plink->found_inx_ser].rx_ports; i++)
     {
         printf("Stats of MIPI RX channel #%d\r\n", i);
 
         printf("Status: %s\r\n",
-                (ser_content.ser_stats[i].global_status == -1) ? "Error" : "OK");
+                (plink->ser_content.ser_stats[i].global_status == -1) ? "Error" : "OK");
 
-        if (ser_content.ser_stats[i].tx_fifo_warn_flag)
+        if (plink->ser_content.ser_stats[i].tx_fifo_warn_flag)
             printf("TX Warning detected\r\n");
 
-        if (ser_content.ser_stats[i].tx_fifo_overflow_flag)
+        if (plink->ser_content.ser_stats[i].tx_fifo_overflow_flag)
             printf("TX Overflow detected\r\n");
 
-        if (ser_content.ser_stats[i].tx_pclk_drift_flag)
+        if (plink->ser_content.ser_stats[i].tx_pclk_drift_flag)
             printf("TX Drift detected\r\n");
 
-        if (ser_content.ser_stats[i].tx_pclk_det_flag)
+        if (plink->ser_content.ser_stats[i].tx_pclk_det_flag)
             printf("TX Clock detected\r\n");
 
-        printf("MIPI RX L LP status: %x\r\n", ser_content.ser_stats[i].mipi_rx_l_lp_errors);
+        printf("MIPI RX L LP status: %x\r\n", plink->ser_content.ser_stats[i].mipi_rx_l_lp_errors);
 
-        printf("MIPI RX L HS error: %x\r\n", ser_content.ser_stats[i].mipi_rx_l_hs_errors);
+        printf("MIPI RX L HS error: %x\r\n", plink->ser_content.ser_stats[i].mipi_rx_l_hs_errors);
 
-        printf("MIPI RX H LP status: %x\r\n", ser_content.ser_stats[i].mipi_rx_h_lp_errors);
+        printf("MIPI RX H LP status: %x\r\n", plink->ser_content.ser_stats[i].mipi_rx_h_lp_errors);
 
-        printf("MIPI RX H HS error: %x\r\n", ser_content.ser_stats[i].mipi_rx_h_hs_errors);
+        printf("MIPI RX H HS error: %x\r\n", plink->ser_content.ser_stats[i].mipi_rx_h_hs_errors);
 
-        printf("CTRL1 CSI L status: %x\r\n", ser_content.ser_stats[i].ctrl1_csi_l_errors);
+        printf("CTRL1 CSI L status: %x\r\n", plink->ser_content.ser_stats[i].ctrl1_csi_l_errors);
 
-        printf("CTRL1 CSI H error: %x\r\n", ser_content.ser_stats[i].ctrl1_csi_h_errors);
+        printf("CTRL1 CSI H error: %x\r\n", plink->ser_content.ser_stats[i].ctrl1_csi_h_errors);
 
-        if (ser_content.ser_stats[i].mipi_dphy_rx_count != -1)
-            printf("MIPI DHPY1 packets received: %d\r\n", ser_content.ser_stats[i].mipi_dphy_rx_count);
+        if (plink->ser_content.ser_stats[i].mipi_dphy_rx_count != -1)
+            printf("MIPI DHPY1 packets received: %d\r\n", plink->ser_content.ser_stats[i].mipi_dphy_rx_count);
 
-        if (ser_content.ser_stats[i].mipi_pkt_processed != -1)
-            printf("MIPI CSI1 packets processed: %d\r\n", ser_content.ser_stats[i].mipi_pkt_processed);
+        if (plink->ser_content.ser_stats[i].mipi_pkt_processed != -1)
+            printf("MIPI CSI1 packets processed: %d\r\n", plink->ser_content.ser_stats[i].mipi_pkt_processed);
 
-        if (ser_content.ser_stats[i].mipi_clk_rx_count != -1)
-            printf("MIPI CSI1 clock received: %d\r\n", ser_content.ser_stats[i].mipi_clk_rx_count);
+        if (plink->ser_content.ser_stats[i].mipi_clk_rx_count != -1)
+            printf("MIPI CSI1 clock received: %d\r\n", plink->ser_content.ser_stats[i].mipi_clk_rx_count);
 
         printf("Mode: %s\r\n",
-                ser_content.ser_stats[i].is_tunnel_mode ? "Tunnel" : "Pixel");
+                plink->ser_content.ser_stats[i].is_tunnel_mode ? "Tunnel" : "Pixel");
 
-        if (ser_content.ser_stats[i].is_tunnel_mode != 0)
+        if (plink->ser_content.ser_stats[i].is_tunnel_mode != 0)
         {
             printf("Tunnel status: %s\r\n",
-                    ser_content.ser_stats[i].is_tunnel_overflow ? "Overflow" : "OK");
+                    plink->ser_content.ser_stats[i].is_tunnel_overflow ? "Overflow" : "OK");
 
-            printf("MIPI tunnel packets processed: %d\r\n", ser_content.ser_stats[i].tunnel_pkt_processed);
+            printf("MIPI tunnel packets processed: %d\r\n", plink->ser_content.ser_stats[i].tunnel_pkt_processed);
         }
 
-        printf("Packet counter   : %d\r\n", ser_content.ser_stats[i].global_pkt_count);
+        printf("Packet counter   : %d\r\n", plink->ser_content.ser_stats[i].global_pkt_count);
 
     }
 
     return 0;
 }
+
+const char *serializer_get_name(pserdes_chain pchain, int link)
+{
+    if (pchain->links[link].found_inx_ser < 0) return NULL;
+    return serializers[pchain->links[link].found_inx_ser].ser_name;
+}
+
+/**
+ * Device ID of the serializer of a link, 0 if none was found
+ * */
+uint8_t serializer_get_devid(pserdes_chain pchain, int link)
+{
+    if (pchain->links[link].found_inx_ser < 0) return 0;
+    return serializers[pchain->links[link].found_inx_ser].ser_devid;
+}
+
+/**
+ * Read register groups of the stats of the serializer of a link for the
+ * monitor, RX port n is in ser_stats[n]. Returns its counters, NULL if no
+ * serializer was found.
+ * */
+const stats_counter_desc *serializer_sample_stats(pserdes_chain pchain, int link, uint32_t groups,
+        int *num_counters, int *num_ports)
+{
+    pserdes_link plink = &pchain->links[link];
+    const serializer_entry *pentry;
+
+    if (plink->found_inx_ser < 0) return NULL;
+
+    pentry = &serializers[plink->found_inx_ser];
+
+    serializer_update_stats(pchain, link, groups);
+
+    *num_counters = pentry->num_counters;
+    *num_ports = pentry->rx_ports;
+
+    return pentry->counters;
+}
+
+void serializer_exit(pserdes_chain pchain)
+{
+    pserdes_link plink;
+    int link;
+
+    for (link = 0; link < pchain->num_links; link++)
+    {
+        plink = &pchain->links[link];
+
+        if (plink->ser_content.regcache == NULL)
+            continue;
+
+        printf("Serializer register cache: %u hits, %u misses\r\n",
+                plink->ser_content.regcache->hits, plink->ser_content.regcache->misses);
+
+        if (plink->ser_content.regcache->delta != 0)
+            printf("Serializer delta mode: %u writes issued, %u elided\r\n",
+                    plink->ser_content.regcache->writes, plink->ser_content.regcache->elided);
+
+        regcache_destroy(plink->ser_content.regcache);
+        plink->ser_content.regcache = NULL;
+    }
+}
@@ -0,0 +1,121 @@
+/**
+ * @file   shm_export.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  Stats export to POSIX shared memory, layout in gmsl_shm.h.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "serdes_head.h"
+#include "gmsl_shm.h"
+
+static gmsl_shm *shm_map;
+
+/**
+ * Create or reuse the segment. Readers of an earlier run may still have
+ * it mapped, so the chains are cleared under their sequence counters,
+ * made even first in case that run was killed in the middle of a write.
+ * */
+int shm_export_open(const char *name, int num_chains)
+{
+    gmsl_shm_chain *pchain;
+    int fd, i;
+
+    fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        printf("Error: can't open shared memory %s: %s\r\n", name, strerror(errno));
+        return -errno;
+    }
+
+    if (ftruncate(fd, sizeof(gmsl_shm)) < 0)
+    {
+        printf("Error: can't size shared memory %s: %s\r\n", name, strerror(errno));
+        close(fd);
+        return -errno;
+    }
+
+    shm_map = mmap(NULL, sizeof(gmsl_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm_map == MAP_FAILED)
+    {
+        printf("Error: can't map shared memory %s: %s\r\n", name, strerror(errno));
+        shm_map = NULL;
+        return -errno;
+    }
+
+    __atomic_store_n(&shm_map->magic, 0, __ATOMIC_RELEASE);
+
+    for (i = 0; i < GMSL_SHM_MAX_CHAINS; i++)
+    {
+        pchain = &shm_map->chains[i];
+        if (pchain->seq & 1)
+            __atomic_store_n(&pchain->seq, pchain->seq + 1, __ATOMIC_RELAXED);
+
+        pchain = shm_export_write_begin(i);
+        memset((char *)pchain + sizeof(pchain->seq), 0, sizeof(gmsl_shm_chain) - sizeof(pchain->seq));
+        pchain->bus = (i < num_chains) ? app_params.chains[i].i2c_port : -1;
+        shm_export_write_end(pchain);
+    }
+
+    shm_map->version = GMSL_SHM_VERSION;
+    shm_map->header_size = offsetof(gmsl_shm, chains);
+    shm_map->chain_size = sizeof(gmsl_shm_chain);
+    shm_map->chip_size = sizeof(gmsl_shm_chip);
+    shm_map->port_size = sizeof(gmsl_shm_port);
+    shm_map->num_chains = (num_chains < GMSL_SHM_MAX_CHAINS) ? num_chains : GMSL_SHM_MAX_CHAINS;
+    shm_map->writer_pid = getpid();
+    __atomic_store_n(&shm_map->magic, GMSL_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/**
+ * The segment stays for readers to see the last stats, writer_pid tells
+ * them nothing updates it any more
+ * */
+void shm_export_close(void)
+{
+    if (shm_map == NULL)
+        return;
+
+    __atomic_store_n(&shm_map->writer_pid, 0, __ATOMIC_RELEASE);
+    munmap(shm_map, sizeof(gmsl_shm));
+    shm_map = NULL;
+}
+
+/**
+ * Chain to update, NULL if there is no export. One writer per chain: the
+ * worker thread of the chain.
+ * */
+gmsl_shm_chain *shm_export_write_begin(int chain)
+{
+    gmsl_shm_chain *pchain;
+
+    if ((shm_map == NULL) || (chain < 0) || (chain >= GMSL_SHM_MAX_CHAINS))
+        return NULL;
+
+    pchain = &shm_map->chains[chain];
+
+    /* Odd before any of the data changes */
+    __atomic_store_n(&pchain->seq, pchain->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    return pchain;
+}
+
+void shm_export_write_end(gmsl_shm_chain *pchain)
+{
+    pchain->updates++;
+
+    /* Even after all of it */
+    __atomic_store_n(&pchain->seq, pchain->seq + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,145 @@
+/**
+ * @file   time_func.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  Monotonic time and poll-until helpers.
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include "serdes_head.h"
+
+#define POLL_INTERVAL_MIN_US    (500)
+#define POLL_INTERVAL_MAX_US    (16000)
+
+typedef struct poll_reg_arg_ {
+    pi2c_bus    bus;
+    uint8_t     dev_addr;
+    uint16_t    reg_addr;
+    uint8_t     mask;
+    uint8_t     value;
+} poll_reg_arg;
+
+/**
+ * Time on the clock of the bus, NULL - CLOCK_MONOTONIC
+ * */
+uint64_t time_monotonic_ns(pi2c_bus pbus)
+{
+    struct timespec ts;
+
+    if ((pbus != NULL) && (pbus->tp->now_ns != NULL))
+        return pbus->tp->now_ns(pbus);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t time_monotonic_us(pi2c_bus pbus)
+{
+    return time_monotonic_ns(pbus) / 1000;
+}
+
+/**
+ * Sleep until an absolute time on the bus clock, restarting on signals
+ * */
+void time_sleep_until_us(pi2c_bus pbus, uint64_t wake_us)
+{
+    struct timespec ts;
+    uint64_t now_us = time_monotonic_us(pbus);
+
+    if (wake_us > now_us)
+        profile_count_sleep(pbus, wake_us - now_us);
+
+    if (pbus->tp->sleep_until_ns != NULL)
+    {
+        pbus->tp->sleep_until_ns(pbus, wake_us * 1000);
+        return;
+    }
+
+    ts.tv_sec = wake_us / 1000000ULL;
+    ts.tv_nsec = (wake_us % 1000000ULL) * 1000;
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+}
+
+void time_sleep_us(pi2c_bus pbus, unsigned int delay_us)
+{
+    time_sleep_until_us(pbus, time_monotonic_us(pbus) + delay_us);
+}
+
+/**
+ * Call cond() until it returns non-zero or timeout_ms runs out. Polling
+ * starts fast and backs off, the last check is made at the deadline.
+ * Returns 0 when the condition was met, -ETIMEDOUT otherwise.
+ * */
+int poll_until(pi2c_bus pbus, int (*cond)(void *arg), void *arg, unsigned int timeout_ms,
+        unsigned int *elapsed_ms)
+{
+    uint64_t start_us, now_us, deadline_us, wake_us;
+    uint32_t interval_us = POLL_INTERVAL_MIN_US;
+    int ret = -ETIMEDOUT;
+
+    start_us = time_monotonic_us(pbus);
+    deadline_us = start_us + (uint64_t)timeout_ms * 1000;
+
+    for (;;)
+    {
+        if (cond(arg) != 0)
+        {
+            ret = 0;
+            break;
+        }
+
+        now_us = time_monotonic_us(pbus);
+        if (now_us >= deadline_us)
+            break;
+
+        wake_us = now_us + interval_us;
+        if (wake_us > deadline_us)
+            wake_us = deadline_us;
+
+        time_sleep_until_us(pbus, wake_us);
+
+        interval_us *= 2;
+        if (interval_us > POLL_INTERVAL_MAX_US)
+            interval_us = POLL_INTERVAL_MAX_US;
+    }
+
+    if (elapsed_ms != NULL)
+        *elapsed_ms = (unsigned int)((time_monotonic_us(pbus) - start_us + 500) / 1000);
+
+    return ret;
+}
+
+static int poll_reg_cond(void *arg)
+{
+    poll_reg_arg *preg = (poll_reg_arg *)arg;
+    uint8_t reg8 = 0;
+
+    if (i2c_read_reg8a16(preg->bus, preg->dev_addr, preg->reg_addr, &reg8) < 0)
+        return 0;
+
+    return ((reg8 & preg->mask) == preg->value);
+}
+
+/**
+ * Wait until (reg & mask) == value, the register is always read from the chip
+ * */
+int poll_reg8a16(pi2c_bus pbus, unsigned char dev_addr, unsigned short reg_addr, unsigned char mask,
+        unsigned char value, unsigned int timeout_ms, unsigned int *elapsed_ms)
+{
+    poll_reg_arg preg;
+
+    preg.bus = pbus;
+    preg.dev_addr = dev_addr;
+    preg.reg_addr = reg_addr;
+    preg.mask = mask;
+    preg.value = value;
+
+    return poll_until(pbus, poll_reg_cond, &preg, timeout_ms, elapsed_ms);
+}
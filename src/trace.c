@@ -0,0 +1,226 @@
+/**
+ * @file   trace.c
+ * @author DAB-Embedded
+ * @date   17 Oct 2026
+ * @brief  I2C transaction tracer.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <linux/i2c.h>
+#include "serdes_head.h"
+
+/* Power of two, the oldest records are overwritten */
+#define TRACE_RING_SIZE     (4096)
+#define TRACE_HIST_BUCKETS  (32)
+#define TRACE_MAX_DEVICES   (128)
+/* Way longer than any register access at 400kHz */
+#define TRACE_SLOW_NS       (10 * 1000 * 1000ULL)
+
+typedef struct trace_record_ {
+    uint64_t    ts_ns;
+    uint32_t    dur_ns;
+    uint16_t    reg_addr;
+    uint16_t    length;     /* Data bytes */
+    uint8_t     dev_addr;
+    uint8_t     dir;        /* 'R', 'W' */
+    int16_t     result;
+    int16_t     err;
+    int16_t     bus;
+} trace_record;
+
+static trace_record trace_ring[TRACE_RING_SIZE];
+/* Index + 1 of the record in the slot, 0 - being written */
+static atomic_uint trace_seq[TRACE_RING_SIZE];
+static atomic_uint trace_head = 0;
+/* Per device log2 histograms of the transfer time in us */
+static atomic_uint trace_hist[TRACE_MAX_DEVICES][TRACE_HIST_BUCKETS];
+static atomic_int trace_dump_req = 0;
+
+static void trace_sigusr1(int sig)
+{
+    (void)sig;
+    atomic_store_explicit(&trace_dump_req, 1, memory_order_relaxed);
+}
+
+void trace_init(void)
+{
+    struct sigaction sa;
+
+    if (app_params.trace == 0)
+        return;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = trace_sigusr1;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
+}
+
+static int trace_bucket(uint64_t dur_ns)
+{
+    uint64_t dur_us = dur_ns / 1000;
+    int bucket = 0;
+
+    while ((dur_us != 0) && (bucket < TRACE_HIST_BUCKETS - 1))
+    {
+        dur_us >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+static void trace_add(const trace_record *prec)
+{
+    unsigned int slot, idx;
+
+    slot = atomic_fetch_add_explicit(&trace_head, 1, memory_order_relaxed);
+    idx = slot & (TRACE_RING_SIZE - 1);
+
+    atomic_store_explicit(&trace_seq[idx], 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    trace_ring[idx] = *prec;
+    atomic_store_explicit(&trace_seq[idx], slot + 1, memory_order_release);
+}
+
+/**
+ * Copy record i out of the ring, fails if it is being written or was
+ * overwritten already
+ * */
+static int trace_get(unsigned int i, trace_record *prec)
+{
+    unsigned int idx = i & (TRACE_RING_SIZE - 1);
+
+    if (atomic_load_explicit(&trace_seq[idx], memory_order_acquire) != i + 1)
+        return -1;
+
+    *prec = trace_ring[idx];
+    atomic_thread_fence(memory_order_acquire);
+
+    return (atomic_load_explicit(&trace_seq[idx], memory_order_relaxed) == i + 1) ? 0 : -1;
+}
+
+/**
+ * Record an I2C_RDWR transfer: one record per register access, the
+ * histogram counts the transfer once against its first device
+ * */
+void trace_transfer(pi2c_bus pbus, const struct i2c_msg *msgs, int nmsgs, uint64_t start_ns,
+        uint64_t dur_ns, int result, int err)
+{
+    trace_record rec;
+    int i;
+
+    if (app_params.trace == 0)
+        return;
+
+    for (i = 0; i < nmsgs; i++)
+    {
+        memset(&rec, 0, sizeof(rec));
+        rec.ts_ns = start_ns;
+        rec.dur_ns = (dur_ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)dur_ns;
+        rec.dev_addr = msgs[i].addr;
+        rec.result = result;
+        rec.err = err;
+        rec.bus = pbus->bus_num;
+
+        if ((i + 1 < nmsgs) && !(msgs[i].flags & I2C_M_RD) &&
+            (msgs[i + 1].flags & I2C_M_RD) && (msgs[i + 1].addr == msgs[i].addr))
+        {
+            /* Register address, then the read */
+            rec.dir = 'R';
+            rec.reg_addr = (msgs[i].len >= 2) ?
+                    ((msgs[i].buf[0] << 8) | msgs[i].buf[1]) : msgs[i].buf[0];
+            rec.length = msgs[i + 1].len;
+            i++;
+        } else if (msgs[i].flags & I2C_M_RD) {
+            rec.dir = 'R';
+            rec.length = msgs[i].len;
+        } else {
+            rec.dir = 'W';
+            if (msgs[i].len >= 3)
+            {
+                rec.reg_addr = (msgs[i].buf[0] << 8) | msgs[i].buf[1];
+                rec.length = msgs[i].len - 2;
+            } else if (msgs[i].len == 2) {
+                rec.reg_addr = msgs[i].buf[0];
+                rec.length = 1;
+            }
+        }
+
+        trace_add(&rec);
+    }
+
+    if (nmsgs > 0)
+    {
+        atomic_fetch_add_explicit(&trace_hist[msgs[0].addr & (TRACE_MAX_DEVICES - 1)]
+                [trace_bucket(dur_ns)], 1, memory_order_relaxed);
+    }
+
+    /* Dump requested by SIGUSR1, done outside of the handler by one thread */
+    if (atomic_exchange_explicit(&trace_dump_req, 0, memory_order_relaxed) != 0)
+        trace_dump();
+}
+
+void trace_dump(void)
+{
+    unsigned int head, first, i;
+    unsigned int count, skipped = 0;
+    trace_record rec;
+    const trace_record *prec = &rec;
+    int dev, b;
+
+    if (app_params.trace == 0)
+        return;
+
+    head = atomic_load_explicit(&trace_head, memory_order_acquire);
+    first = (head > TRACE_RING_SIZE) ? head - TRACE_RING_SIZE : 0;
+
+    printf("======== I2C trace (%u of %u) ===========\r\n", head - first, head);
+
+    for (i = first; i != head; i++)
+    {
+        if (trace_get(i, &rec) < 0)
+        {
+            skipped++;
+            continue;
+        }
+
+        printf("%llu.%06llu i2c-%d 0x%02X %c 0x%04X len %-3u %8.3f us ret %d",
+                (unsigned long long)(prec->ts_ns / 1000000000ULL),
+                (unsigned long long)((prec->ts_ns / 1000) % 1000000ULL),
+                prec->bus, prec->dev_addr, prec->dir, prec->reg_addr, prec->length,
+                prec->dur_ns / 1000.0, prec->result);
+
+        if (prec->result < 0)
+            printf(" ERR %s", strerror(prec->err));
+        if (prec->dur_ns >= TRACE_SLOW_NS)
+            printf(" SLOW");
+
+        printf("\r\n");
+    }
+
+    if (skipped != 0)
+        printf("%u records being written, skipped\r\n", skipped);
+
+    printf("======== I2C latency =====================\r\n");
+
+    for (dev = 0; dev < TRACE_MAX_DEVICES; dev++)
+    {
+        for (b = 0; b < TRACE_HIST_BUCKETS; b++)
+        {
+            count = atomic_load_explicit(&trace_hist[dev][b], memory_order_relaxed);
+            if (count == 0)
+                continue;
+
+            if (b == 0)
+                printf("0x%02X      < 1 us: %u\r\n", dev, count);
+            else
+                printf("0x%02X < %7u us: %u\r\n", dev, 1u << b, count);
+        }
+    }
+}